@@ -0,0 +1,51 @@
+#ifndef AL_BENCH_H_
+#define AL_BENCH_H_
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "altair/aldefs.h"
+
+// timings go to stderr, so the library's log on stdout can be thrown away with >/dev/null
+
+typedef char BenchPath[256];
+
+// 'count' copies of the plugin at 'source' in a fresh directory; each has its own inode, so
+// dlopen loads every one as a library of its own. false if any could not be made.
+static b8 s_CopyPlugins(const char* source, u64 count, BenchPath directory, BenchPath* paths) {
+    snprintf(directory, sizeof(BenchPath), "/tmp/altair-bench-XXXXXX");
+    if (!mkdtemp(directory)) return false;
+
+    i32         input = open(source, O_RDONLY);
+    struct stat info;
+    if (input == -1 || fstat(input, &info) != 0) return false;
+
+    for (u64 i = 0; i < count; ++i) {
+        snprintf(paths[i], sizeof(BenchPath), "%s/libbench%llu.so", directory, i);
+
+        i32   output = open(paths[i], O_WRONLY | O_CREAT | O_TRUNC, 0755);
+        off_t offset = 0;
+        b8    copied = output != -1 &&
+                    sendfile(output, input, &offset, info.st_size) == info.st_size;
+
+        if (output != -1) close(output);
+        if (!copied) {
+            close(input);
+            return false;
+        }
+    }
+
+    close(input);
+    return true;
+}
+
+static void s_RemovePlugins(const BenchPath directory, const BenchPath* paths, u64 count) {
+    for (u64 i = 0; i < count; ++i) unlink(paths[i]);
+    rmdir(directory);
+}
+
+#endif
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "altair.h"
+#include "bench.h"
+
+// frame time of N plugins updating serially on the dispatching thread, against the same
+// plugins built PLUGIN_PARALLEL and fanned out over the work-stealing executor.
+// usage: bench-dispatch [plugins] [update_us] [frames]
+
+static u64 s_MeasureFrames(const char* source, u64 count, u64 frames) {
+    BenchPath  directory;
+    BenchPath* paths = malloc(count * sizeof(BenchPath));
+    if (!s_CopyPlugins(source, count, directory, paths)) {
+        fprintf(stderr, "could not copy '%s'\n", source);
+        exit(1);
+    }
+
+    AL_PluginManager manager;
+    AL_CreatePluginManager(&manager);
+
+    const char** filepaths = malloc(count * sizeof(const char*));
+    for (u64 i = 0; i < count; ++i) filepaths[i] = paths[i];
+    AL_RegisterPlugins(&manager, filepaths, count);
+
+    // warms the workers and the snapshot up
+    AL_DispatchUpdate(&manager, 0);
+
+    u64 begin = AL_GetTime();
+    for (u64 frame = 1; frame <= frames; ++frame) AL_DispatchUpdate(&manager, frame);
+    u64 elapsed = AL_GetTime() - begin;
+
+    AL_DestroyPluginManager(&manager);
+    s_RemovePlugins(directory, (const BenchPath*)paths, count);
+    free(filepaths);
+    free(paths);
+    return elapsed / frames;
+}
+
+int main(int argc, char* argv[]) {
+    u64 count     = argc > 1 ? strtoull(argv[1], NULL, 10) : 32;
+    u64 update_us = argc > 2 ? strtoull(argv[2], NULL, 10) : 100;
+    u64 frames    = argc > 3 ? strtoull(argv[3], NULL, 10) : 200;
+
+    char cost[32];
+    snprintf(cost, sizeof(cost), "%llu", update_us);
+    setenv("ALTAIR_BENCH_UPDATE_US", cost, true);
+
+    u64 serial   = s_MeasureFrames(BENCH_PLUGIN, count, frames);
+    u64 parallel = s_MeasureFrames(BENCH_PLUGIN_PARALLEL, count, frames);
+
+    fprintf(
+        stderr, "%llu plugins, %lluus update each, %llu frames, %u cores\n", count, update_us,
+        frames, AL_GetCoreCount()
+    );
+    fprintf(stderr, "  serial updates    %8.3f ms/frame\n", (double)serial / AL_NS_PER_MS);
+    fprintf(stderr, "  parallel updates  %8.3f ms/frame\n", (double)parallel / AL_NS_PER_MS);
+    fprintf(stderr, "  scaling           %8.2fx\n", (double)serial / parallel);
+    return 0;
+}
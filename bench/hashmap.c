@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "altair.h"
+#include "altair/hash.h"
+#include "bench.h"
+
+// registry lookups by path against a populated manager: AL_QueryHandle, and AL_Query on top
+// of it, against a scan of the registry's plugins like the one the index replaced. all three
+// hash the path and read inside the manager's epoch. usage: bench-hashmap [max_plugins]
+
+#define LOOKUPS 2000000
+
+static u64 s_Next(u64* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static AL_Plugin* s_Scan(AL_PluginManager* manager, const char* filepath) {
+    u64                hash     = FNV_1A_C(filepath, strlen(filepath));
+    AL_Plugin*         plugin   = NULL;
+    const AL_Registry* registry = AL_AcquireRegistry(manager);
+
+    AL_ForEach(registry->plugins, i) {
+        if (registry->plugins[i]->uuid != hash) continue;
+        plugin = registry->plugins[i];
+        break;
+    }
+
+    AL_ReleaseRegistry(manager);
+    return plugin;
+}
+
+static void s_Measure(const BenchPath* paths, u64 count) {
+    AL_PluginManager manager;
+    AL_CreatePluginManager(&manager);
+
+    const char** filepaths = malloc(count * sizeof(const char*));
+    for (u64 i = 0; i < count; ++i) filepaths[i] = paths[i];
+
+    u64 registered = AL_RegisterPlugins(&manager, filepaths, count);
+    free(filepaths);
+
+    if (registered != count) {
+        fprintf(stderr, "only %llu of %llu plugins registered\n", registered, count);
+        AL_DestroyPluginManager(&manager);
+        return;
+    }
+
+    // the scan is linear, so fewer lookups keep the big counts bearable
+    u64 scans = count > 100 ? LOOKUPS / 100 : LOOKUPS;
+    u64 state = 0x9E3779B97F4A7C15;
+    u64 found = 0;
+
+    u64 begin = AL_GetTime();
+    for (u64 i = 0; i < LOOKUPS; ++i) {
+        found += AL_QueryHandle(&manager, paths[s_Next(&state) % count], false).generation != 0;
+    }
+    u64 handles = AL_GetTime() - begin;
+
+    begin       = AL_GetTime();
+    for (u64 i = 0; i < LOOKUPS; ++i) {
+        found += AL_Query(&manager, paths[s_Next(&state) % count], false) != NULL;
+    }
+    u64 queries = AL_GetTime() - begin;
+
+    begin       = AL_GetTime();
+    for (u64 i = 0; i < scans; ++i) {
+        found += s_Scan(&manager, paths[s_Next(&state) % count]) != NULL;
+    }
+    u64 scanned = AL_GetTime() - begin;
+
+    if (found != 2 * LOOKUPS + scans) fprintf(stderr, "lookups missed\n");
+
+    fprintf(
+        stderr, "%6llu plugins  AL_QueryHandle %6.1f ns  AL_Query %6.1f ns  scan %8.1f ns\n", count,
+        (double)handles / LOOKUPS, (double)queries / LOOKUPS, (double)scanned / scans
+    );
+
+    AL_DestroyPluginManager(&manager);
+}
+
+int main(int argc, char* argv[]) {
+    u64 most = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000;
+    if (most == 0) return 1;
+
+    BenchPath  directory;
+    BenchPath* paths = malloc(most * sizeof(BenchPath));
+    if (!s_CopyPlugins(BENCH_PLUGIN, most, directory, paths)) {
+        fprintf(stderr, "could not copy '%s'\n", BENCH_PLUGIN);
+        return 1;
+    }
+
+    for (u64 count = 10; count <= most; count *= 10) s_Measure((const BenchPath*)paths, count);
+
+    s_RemovePlugins(directory, (const BenchPath*)paths, most);
+    free(paths);
+    return 0;
+}
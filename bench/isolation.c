@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "altair.h"
+#include "bench.h"
+
+// frame time of N plugins updating in-process against the same plugins built PLUGIN_ISOLATED,
+// where every update is a round trip to a host process. with no update cost it measures the
+// crossing alone. then the round trip of an AL_SendMessage echoed by one of them.
+// usage: bench-isolation [plugins] [update_us] [frames]
+
+#define MESSAGES     10000
+#define MESSAGE_SIZE 256
+
+// ns per echoed message
+static u64 s_MeasureMessages(AL_PluginManager* manager, const char* filepath) {
+    u8         message[MESSAGE_SIZE] = { 0 };
+    u8         reply[MESSAGE_SIZE];
+    AL_Plugin* plugin = AL_Query(manager, filepath, true);
+    if (!plugin) return 0;
+
+    u64 begin = AL_GetTime();
+    for (u64 i = 0; i < MESSAGES; ++i) {
+        message[0] = (u8)i;
+        if (AL_SendMessage(plugin, message, sizeof(message), reply, sizeof(reply)) !=
+                MESSAGE_SIZE ||
+            reply[0] != (u8)i) {
+            fprintf(stderr, "message %llu to '%s' was not echoed\n", i, filepath);
+            exit(1);
+        }
+    }
+
+    return (AL_GetTime() - begin) / MESSAGES;
+}
+
+static u64 s_MeasureFrames(const char* source, u64 count, u64 frames, u64* message_ns) {
+    BenchPath  directory;
+    BenchPath* paths = malloc(count * sizeof(BenchPath));
+    if (!s_CopyPlugins(source, count, directory, paths)) {
+        fprintf(stderr, "could not copy '%s'\n", source);
+        exit(1);
+    }
+
+    AL_PluginManager manager;
+    AL_CreatePluginManager(&manager);
+
+    const char** filepaths = malloc(count * sizeof(const char*));
+    for (u64 i = 0; i < count; ++i) filepaths[i] = paths[i];
+
+    u64 registered = AL_RegisterPlugins(&manager, filepaths, count);
+    if (registered != count) fprintf(stderr, "only %llu of %llu registered\n", registered, count);
+
+    // warms the hosts and the snapshot up
+    AL_DispatchUpdate(&manager, 0);
+
+    u64 begin = AL_GetTime();
+    for (u64 frame = 1; frame <= frames; ++frame) AL_DispatchUpdate(&manager, frame);
+    u64 elapsed = AL_GetTime() - begin;
+    *message_ns = s_MeasureMessages(&manager, paths[0]);
+
+    AL_DestroyPluginManager(&manager);
+    s_RemovePlugins(directory, (const BenchPath*)paths, count);
+    free(filepaths);
+    free(paths);
+    return elapsed / frames;
+}
+
+int main(int argc, char* argv[]) {
+    u64 count     = argc > 1 ? strtoull(argv[1], NULL, 10) : 16;
+    u64 update_us = argc > 2 ? strtoull(argv[2], NULL, 10) : 0;
+    u64 frames    = argc > 3 ? strtoull(argv[3], NULL, 10) : 1000;
+
+    if (count > AL_HOST_MAX) {
+        fprintf(stderr, "at most %u plugins can be isolated at once\n", AL_HOST_MAX);
+        return 1;
+    }
+
+    char cost[32];
+    snprintf(cost, sizeof(cost), "%llu", update_us);
+    setenv("ALTAIR_BENCH_UPDATE_US", cost, true);
+    setenv("ALTAIR_HOST", BENCH_HOST, false);
+
+    u64 local_message, isolated_message;
+    u64 local    = s_MeasureFrames(BENCH_PLUGIN, count, frames, &local_message);
+    u64 isolated = s_MeasureFrames(BENCH_PLUGIN_ISOLATED, count, frames, &isolated_message);
+
+    fprintf(
+        stderr, "%llu plugins, %lluus update each, %llu frames, %u cores\n", count, update_us,
+        frames, AL_GetCoreCount()
+    );
+    fprintf(stderr, "  in-process updates  %8.3f ms/frame\n", (double)local / AL_NS_PER_MS);
+    fprintf(stderr, "  isolated updates    %8.3f ms/frame\n", (double)isolated / AL_NS_PER_MS);
+    fprintf(
+        stderr, "  per isolated call   %8.2f us extra\n",
+        (double)(isolated - local) / count / AL_NS_PER_US
+    );
+    fprintf(
+        stderr, "  %uB message echoed  %8.2f us in-process, %.2f us isolated\n", MESSAGE_SIZE,
+        (double)local_message / AL_NS_PER_US, (double)isolated_message / AL_NS_PER_US
+    );
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "altair.h"
+
+// the plugin the benchmarks register, built once per kind of dispatch they compare. its
+// costs come from the environment, in microseconds: ALTAIR_BENCH_INIT_US is spent in init,
+// ALTAIR_BENCH_UPDATE_US in every update. messages are echoed back.
+#if defined(BENCH_PARALLEL)
+AL_DESCRIBE_PLUGIN(.type = PLUGIN_OTHER | PLUGIN_PARALLEL, .entries = ENTRY_INIT | ENTRY_UPDATE);
+#elif defined(BENCH_ISOLATED)
+AL_DESCRIBE_PLUGIN(.type = PLUGIN_OTHER | PLUGIN_ISOLATED, .entries = ENTRY_INIT | ENTRY_UPDATE);
+#else
+AL_DESCRIBE_PLUGIN(.type = PLUGIN_OTHER, .entries = ENTRY_INIT | ENTRY_UPDATE);
+#endif
+
+static u64 s_update_ns = 0;
+
+static u64 s_Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+// busy, like a plugin doing real work, rather than asleep
+static void s_Spin(u64 ns) {
+    u64 end = s_Now() + ns;
+    while (s_Now() < end) continue;
+}
+
+static u64 s_ReadMicroseconds(const char* name) {
+    const char* value = getenv(name);
+    return value ? strtoull(value, NULL, 10) * 1000ull : 0;
+}
+
+ALAPI b8 init(AL_PluginManager* manager, AL_Plugin* plugin) {
+    (void)manager;
+    (void)plugin;
+
+    s_update_ns = s_ReadMicroseconds("ALTAIR_BENCH_UPDATE_US");
+    s_Spin(s_ReadMicroseconds("ALTAIR_BENCH_INIT_US"));
+    return true;
+}
+
+ALAPI void update(u64 frame) {
+    (void)frame;
+    s_Spin(s_update_ns);
+}
+
+ALAPI u64 message(const void* data, u64 size, void* reply, u64 capacity) {
+    u64 echoed = size < capacity ? size : capacity;
+    memcpy(reply, data, echoed);
+    return echoed;
+}
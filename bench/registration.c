@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "altair.h"
+#include "bench.h"
+
+// startup: registering N plugins one AL_RegisterPlugin at a time against one AL_RegisterPlugins
+// batch, each into a fresh manager. usage: bench-registration [plugins] [init_us]
+
+static u64 s_RegisterSerial(const BenchPath* paths, u64 count) {
+    AL_PluginManager manager;
+    AL_CreatePluginManager(&manager);
+
+    u64 begin = AL_GetTime();
+    for (u64 i = 0; i < count; ++i) AL_RegisterPlugin(&manager, paths[i]);
+    u64 elapsed = AL_GetTime() - begin;
+
+    AL_DestroyPluginManager(&manager);
+    return elapsed;
+}
+
+static u64 s_RegisterBatch(const BenchPath* paths, u64 count) {
+    AL_PluginManager manager;
+    AL_CreatePluginManager(&manager);
+
+    const char** filepaths = malloc(count * sizeof(const char*));
+    for (u64 i = 0; i < count; ++i) filepaths[i] = paths[i];
+
+    u64 begin      = AL_GetTime();
+    u64 registered = AL_RegisterPlugins(&manager, filepaths, count);
+    u64 elapsed    = AL_GetTime() - begin;
+
+    if (registered != count) fprintf(stderr, "only %llu of %llu registered\n", registered, count);
+
+    free(filepaths);
+    AL_DestroyPluginManager(&manager);
+    return elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    u64 count   = argc > 1 ? strtoull(argv[1], NULL, 10) : 64;
+    u64 init_us = argc > 2 ? strtoull(argv[2], NULL, 10) : 2000;
+
+    char cost[32];
+    snprintf(cost, sizeof(cost), "%llu", init_us);
+    setenv("ALTAIR_BENCH_INIT_US", cost, true);
+
+    BenchPath  directory;
+    BenchPath* paths = malloc(count * sizeof(BenchPath));
+    if (!s_CopyPlugins(BENCH_PLUGIN, count, directory, paths)) {
+        fprintf(stderr, "could not copy '%s'\n", BENCH_PLUGIN);
+        return 1;
+    }
+
+    u64 serial = s_RegisterSerial((const BenchPath*)paths, count);
+    u64 batch  = s_RegisterBatch((const BenchPath*)paths, count);
+
+    fprintf(
+        stderr, "%llu plugins, %lluus init each, %u cores\n", count, init_us, AL_GetCoreCount()
+    );
+    fprintf(stderr, "  serial AL_RegisterPlugin  %8.2f ms\n", (double)serial / AL_NS_PER_MS);
+    fprintf(stderr, "  batch AL_RegisterPlugins  %8.2f ms\n", (double)batch / AL_NS_PER_MS);
+    fprintf(stderr, "  speedup                   %8.2fx\n", (double)serial / batch);
+
+    s_RemovePlugins(directory, (const BenchPath*)paths, count);
+    free(paths);
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "altair.h"
+#include "altair/atomic.h"
+
+// cost of the sync flag on its hot paths: reads and writes with nobody else around, then
+// readers polling one flag while a writer keeps setting it.
+// usage: bench-syncflag [readers] [contended_ms]
+
+#define OPERATIONS 10000000
+#define READERS    64
+
+static AL_Mutex s_mutex;
+static u32      s_stop = 0; // atomic
+
+static void*    s_ReaderProc(void* argument) {
+    u64* reads = argument;
+    while (!AL_AtomicLoad(&s_stop, AL_RELAXED)) {
+        AL_ReadSyncFlag(&s_mutex);
+        *reads += 1;
+    }
+
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    u64 readers      = argc > 1 ? strtoull(argv[1], NULL, 10) : 4;
+    u64 contended_ms = argc > 2 ? strtoull(argv[2], NULL, 10) : 500;
+    if (readers > READERS) readers = READERS;
+
+    s_mutex   = AL_CreateMutex();
+
+    u64 begin = AL_GetTime();
+    for (u64 i = 0; i < OPERATIONS; ++i) AL_ReadSyncFlag(&s_mutex);
+    u64 read = AL_GetTime() - begin;
+
+    begin    = AL_GetTime();
+    for (u64 i = 0; i < OPERATIONS; ++i) AL_WriteSyncFlag(&s_mutex, SYNC_UNSET);
+    u64 written = AL_GetTime() - begin;
+
+    // the reader threads poll like plugin threads do; nothing sleeps, so no write wakes anyone
+    pthread_t threads[READERS];
+    u64       reads[READERS] = { 0 };
+    for (u64 i = 0; i < readers; ++i) pthread_create(threads + i, NULL, s_ReaderProc, reads + i);
+
+    u64 writes = 0;
+    begin      = AL_GetTime();
+    while (AL_GetTime() - begin < contended_ms * AL_NS_PER_MS) {
+        AL_WriteSyncFlag(&s_mutex, SYNC_WAIT);
+        writes += 1;
+    }
+
+    AL_AtomicStore(&s_stop, 1, AL_RELAXED);
+
+    u64 total = 0;
+    for (u64 i = 0; i < readers; ++i) {
+        pthread_join(threads[i], NULL);
+        total += reads[i];
+    }
+
+    fprintf(stderr, "%u cores\n", AL_GetCoreCount());
+    fprintf(stderr, "  read, uncontended     %8.1f ns\n", (double)read / OPERATIONS);
+    fprintf(stderr, "  write, no waiter      %8.1f ns\n", (double)written / OPERATIONS);
+    fprintf(
+        stderr, "  %llu readers + writer  %llu reads, %llu writes in %llums\n", readers, total,
+        writes, contended_ms
+    );
+
+    AL_DestroyMutex(&s_mutex);
+    return 0;
+}
@@ -0,0 +1,4 @@
+#include <altair.h>
+
+// child process of the runtime, serving a single PLUGIN_ISOLATED plugin
+int main(int argc, char* argv[]) { return AL_RunHost(argc, argv); }
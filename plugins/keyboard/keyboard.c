@@ -1,34 +1,19 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <linux/input.h>
-#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 #include "altair.h"
-ALAPI const u32   type = PLUGIN_KEYBOARD | PLUGIN_ASYNC;
+AL_DESCRIBE_PLUGIN(.type = PLUGIN_KEYBOARD, .entries = ENTRY_INIT | ENTRY_CLEANUP);
 
-struct pollfd     poller;
+i32               input    = -1;
+b8                watching = false;
 AL_PluginManager* manager;
 
-ALAPI b8          init(AL_PluginManager* manager_) {
-    manager       = manager_;
-    poller.fd     = 0; // open("/dev/input/event4", O_RDONLY | O_NONBLOCK);
-    poller.events = POLLIN;
-
-    if (poller.fd == -1) {
-        switch (errno) {
-        case EACCES: LERROR("No permission to read /dev/input/."); break;
-        default: LERROR("Could not initialize keyboard."); break;
-        }
-        return false;
-    }
-
-    return true;
-}
-
 typedef struct {
     struct timeval time;
     __U16_TYPE     type;
@@ -36,47 +21,72 @@ typedef struct {
     __S32_TYPE     value;
 } InputEvent;
 
-u64       event_size = sizeof(InputEvent);
-u8        max_events = 10;
+u64         event_size = sizeof(InputEvent);
+u8          max_events = 10;
+
+// runs on the manager's reactor whenever input is waiting, so there's no loop to stop
+static void on_input(i32 fd, u32 events, void* user_context) {
+    (void)user_context;
+    u8      buffer[event_size * max_events];
 
-ALAPI u32 proc(AL_Plugin* self) {
-    u8         buffer[event_size * max_events];
-    AL_Thread* thread = &self->opt.thread;
+    ssize_t bytes_read = read(fd, (void*)buffer, event_size * max_events);
+    if (bytes_read == -1) return;
 
-    AL_AsyncWhile(&thread->mutex, SYNC_EXIT) {
-        if (poll(&poller, 1, 100) <= 0) continue;
-        if (!poller.revents) continue;
+    // closed; it would otherwise be ready forever
+    if (bytes_read == 0 || (events & REACTOR_CLOSED)) {
+        LNOTE("Keyboard input closed.");
+        watching = !AL_UnwatchFd(&manager->reactor, fd);
+        return;
+    }
 
-        ssize_t bytes_read = 0; // read(poller.fd, (void*)buffer, event_size * max_events);
-        if (bytes_read == -1) {
-            switch (errno) {
-            case EAGAIN: break;
-            default: break;
-            }
-            continue;
+    for (u64 byte = 0; byte < bytes_read; byte += event_size) {
+        InputEvent* event = (InputEvent*)(buffer + byte);
+        if (event->type != EV_KEY) continue;
+
+        switch (event->code) {
+        case KEY_Q:
+            LNOTE("Exiting");
+            AL_WriteSyncFlag(&manager->mutex, SYNC_EXIT);
+            break;
+        default: break;
         }
+    }
+}
 
-        for (u64 byte = 0; byte < bytes_read; byte += event_size) {
-            InputEvent* event = (InputEvent*)(buffer + byte);
-            if (event->type != EV_KEY) continue;
-
-            switch (event->code) {
-            case KEY_Q:
-                AL_WriteSyncFlag(&manager->mutex, SYNC_EXIT);
-                // goto end;
-                break;
-            default: break;
-            }
+ALAPI b8 init(AL_PluginManager* manager_) {
+    manager = manager_;
+    input   = dup(STDIN_FILENO); // open("/dev/input/event4", O_RDONLY | O_NONBLOCK);
+
+    if (input == -1) {
+        switch (errno) {
+        case EACCES: LERROR("No permission to read /dev/input/."); break;
+        default: LERROR("Could not initialize keyboard."); break;
         }
+        return false;
+    }
+
+    // stdin redirected from a file or /dev/null can't be waited on; the runtime still runs,
+    // detached, just without keys
+    if (!AL_WatchFd(&manager->reactor, input, REACTOR_READ, on_input, NULL)) {
+        LWARN("Keyboard input can't be watched; keys are ignored.");
+        close(input);
+        input = -1;
+        return true;
     }
 
-end:
-    LNOTE("Exiting");
-    AL_WakeCondition(&thread->mutex);
+    watching = true;
     return true;
 }
 
 ALAPI b8 cleanup(void) {
-    close(poller.fd);
+    if (input == -1) return true;
+
+    // returns once no input callback is running
+    if (watching) AL_UnwatchFd(&manager->reactor, input);
+    close(input);
+
+    // a reload starts from scratch rather than from the closed descriptor
+    input    = -1;
+    watching = false;
     return true;
 }
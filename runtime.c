@@ -1,4 +1,5 @@
 #include <altair.h>
+#include <stdlib.h>
 
 static void on_add(AL_String directory, AL_String file, void* argument) {
     AL_PluginManager* manager   = argument;
@@ -6,9 +7,16 @@ static void on_add(AL_String directory, AL_String file, void* argument) {
     AL_String         full_path = AL_Copy(directory);
     full_path                   = AL_Concat(full_path, file);
 
-    if (AL_Query(manager, full_path, false)) return;
+    // a query would load a lazily registered plugin
+    if (AL_QueryHandle(manager, full_path, false).generation != 0) {
+        AL_Free(full_path);
+        return;
+    }
 
-    AL_RegisterPlugin(manager, full_path);
+    // plugins load on first use instead, when the manager is set to
+    if (manager->lazy) AL_RegisterPluginLazy(manager, full_path);
+    else
+        AL_RegisterPlugin(manager, full_path);
     AL_Free(full_path);
 }
 
@@ -23,18 +31,25 @@ static void on_remove(AL_String directory, AL_String file, void* argument) {
 }
 
 static void on_modify(AL_String dir, AL_String file, void* argument) {
-    AL_PluginManager* manager   = argument;
+    AL_ReloadTransaction* reload    = argument;
 
-    AL_String         full_path = AL_Copy(dir);
-    full_path                   = AL_Concat(full_path, file);
+    AL_String             full_path = AL_Copy(dir);
+    full_path                       = AL_Concat(full_path, file);
 
-    if (AL_Query(manager, full_path, false)) {
-        if (!AL_UnregisterPlugin(manager, full_path)) return AL_Free(full_path);
-    }
+    AL_StageReload(reload, full_path);
+    AL_Free(full_path);
+}
 
-    if (!AL_RegisterPlugin(manager, full_path)) return;
+// plugins rebuilt together swap in together, against each other's new builds
+static void on_flush(AL_String dir, AL_String file, void* argument) {
+    (void)dir;
+    (void)file;
 
-    AL_Free(full_path);
+    AL_ReloadTransaction* reload  = argument;
+    AL_PluginManager*     manager = reload->manager;
+
+    AL_CommitReload(reload);
+    AL_BeginReload(manager, reload);
 }
 
 int main(int argc, char* argv[]) {
@@ -47,43 +62,113 @@ int main(int argc, char* argv[]) {
         plugins_dir = AL_CopyC(argv[1], strlen(argv[1]));
     }
 
+    // spans of loads, inits, updates and unloads, as a Chrome trace
+    const char* trace = getenv("ALTAIR_TRACE");
+    if (trace) AL_StartTrace(trace);
+
     AL_PluginManager manager;
     if (!AL_CreatePluginManager(&manager)) {
         LERROR("Could not initialize plugin manager.");
         return 1;
     }
 
+    // unchanged plugins skip inspection on the next start
+    const char* cache_path = getenv("ALTAIR_CACHE");
+    AL_String   cache      = AL_Copy(plugins_dir);
+    cache                  = AL_ConcatC(cache, "/.altair-cache", 15);
+
+    if (!AL_OpenMetadataCache(&manager, cache_path ? cache_path : cache))
+        LWARN("Running without a plugin metadata cache.");
+    AL_Free(cache);
+
+    // plugins already on disk are picked up as modified by the watcher's startup pass, so
+    // lazy loading has to be on before it starts
+    AL_SetLazyLoading(&manager, getenv("ALTAIR_LAZY") != NULL);
+
+    const char* idle = getenv("ALTAIR_IDLE_MS");
+    AL_SetIdleUnload(&manager, idle ? strtoul(idle, NULL, 10) : 0);
+
+    AL_ReloadTransaction reload;
+    AL_BeginReload(&manager, &reload);
+
     AL_FileWatcher watcher;
-    if (!AL_CreateFileWatcher(plugins_dir, 2, "*.so*", 1000, &watcher)) {
+    if (!AL_CreateFileWatcher(plugins_dir, 2, "*.so*", &manager.reactor, &watcher)) {
         LERROR("Could not create filewatcher.");
         return 1;
     }
 
     AL_AddFileCallback(&watcher, on_add, FILE_ADDED, &manager);
     AL_AddFileCallback(&watcher, on_remove, FILE_REMOVED, &manager);
-    AL_AddFileCallback(&watcher, on_modify, FILE_MODIFIED, &manager);
+    AL_AddFileCallback(&watcher, on_modify, FILE_MODIFIED, &reload);
+    AL_AddFileCallback(&watcher, on_flush, FILE_FLUSHED, &reload);
+
+    // a rebuilt plugin is reloaded once its file has settled
+    const char* quiet = getenv("ALTAIR_QUIET_MS");
+    if (quiet) AL_SetQuietWindow(&watcher, strtoul(quiet, NULL, 10));
+
+    // variable step; the tick rate can be overridden from the command line
+    AL_Scheduler scheduler;
+    u32          tick_rate = argc > 2 ? strtoul(argv[2], NULL, 10) : 60;
+    AL_CreateScheduler(tick_rate, false, &scheduler);
+
+    // per-plugin update timings, against the frame budget, are off unless asked for
+    b8 profile = getenv("ALTAIR_PROFILE") != NULL;
+    AL_SetUpdateBudget(&manager, AL_NS_PER_S / (tick_rate ? tick_rate : 60));
+    AL_SetSampling(&manager, profile);
+
+    // async plugins that stop checking in are quarantined; updates are watched only on request
+    const char* deadline = getenv("ALTAIR_DEADLINE_MS");
+    AL_SetWatchdog(&manager, deadline ? strtoul(deadline, NULL, 10) : 0, 5000);
 
-    u64 frame = 0;
     AL_AsyncWhile(&manager.mutex, SYNC_EXIT) {
-        AL_ForEach(manager.registry, i) {
-            AL_Plugin* plugin = manager.registry + i;
+        u64 frame = AL_WaitFrame(&scheduler);
+        AL_DispatchUpdate(&manager, frame);
+
+        // often enough that no thread laps its ring
+        if (frame % 64 == 0 && AL_IsTracing()) AL_FlushTrace();
+    }
 
-            if ((plugin->type & PLUGIN_ASYNC) || !plugin->opt.update) continue;
-            else
-                plugin->opt.update(frame);
-        }
+    AL_FrameStats stats;
+    AL_GetFrameStats(&scheduler, &stats);
+    LINFO(
+        "%llu frames: %.3fms mean, %.3fms jitter, %llu overruns.", stats.frames,
+        stats.mean_ns / AL_NS_PER_MS, stats.jitter_ns / AL_NS_PER_MS, stats.overruns
+    );
+
+    const AL_Registry* registry = AL_AcquireRegistry(&manager);
+    AL_ForEach(registry->plugins, i) {
+        const char*    filepath = registry->plugins[i]->handle.filepath;
+        AL_PluginStats plugin;
+
+        if (!profile || !AL_GetPluginStats(&manager, filepath, &plugin) || !plugin.calls) continue;
+        LINFO(
+            "'%s': %llu updates, %.3fms mean, %.3fms p99, %.3fms max, %llu over budget.", filepath,
+            plugin.calls, (f64)plugin.mean_ns / AL_NS_PER_MS, (f64)plugin.p99_ns / AL_NS_PER_MS,
+            (f64)plugin.max_ns / AL_NS_PER_MS, plugin.overruns
+        );
     }
+    AL_ReleaseRegistry(&manager);
+
+    AL_FileWatcherStats events;
+    AL_GetFileWatcherStats(&watcher, &events);
+    LINFO(
+        "%llu file events: %llu handed out, %llu coalesced, %llu windows extended for writes.",
+        events.events, events.emitted, events.coalesced, events.unsettled
+    );
 
     if (!AL_DestroyFileWatcher(&watcher)) {
         LERROR("Could not destroy filewatcher.");
         return 1;
     }
 
+    AL_AbortReload(&reload);
+
     if (!AL_DestroyPluginManager(&manager)) {
         LERROR("Could not destroy plugin manager.");
         return 1;
     }
 
+    if (AL_IsTracing()) AL_StopTrace();
     AL_Free(plugins_dir);
 
     LSUCCESS("Successful shutdown.");
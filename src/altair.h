@@ -3,10 +3,16 @@
 
 #include "altair/aldefs.h"
 #include "altair/array.h"
+#include "altair/clock.h"
+#include "altair/coroutine.h"
 #include "altair/filewatcher.h"
+#include "altair/host.h"
 #include "altair/log.h"
 #include "altair/manager.h"
 #include "altair/plugin.h"
+#include "altair/reactor.h"
+#include "altair/scheduler.h"
 #include "altair/string.h"
+#include "altair/trace.h"
 
 #endif
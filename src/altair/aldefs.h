@@ -7,7 +7,8 @@
 #    include <Windows.h>
 
 #    define AL_PLATFORM_WIN
-#    define AL_MAX_PATH (MAX_PATH - 1)
+#    define AL_MAX_PATH     (MAX_PATH - 1)
+#    define AL_THREAD_LOCAL __declspec(thread)
 
 #    if defined(ALCORE) || defined(ALPLUGIN)
 #        define ALAPI __declspec(dllexport)
@@ -26,6 +27,7 @@
 #    define AL_PLATFORM_UNIX
 #    define AL_MAX_PATH     (PATH_MAX - 1)
 #    define AL_PARENT(path) dirname(path)
+#    define AL_THREAD_LOCAL __thread
 
 #    if (defined(__GNUC__) || defined(__clang__))
 #        define ALAPI __attribute__((visibility("default")))
@@ -39,8 +41,10 @@
 #    pragma error "OS not supported."
 #endif
 
-#define true  1
-#define false 0
+#define true          1
+#define false         0
+
+#define AL_CACHE_LINE 64
 
 typedef _Bool              b8;
 
@@ -48,6 +52,9 @@ typedef unsigned char      u8;
 typedef unsigned int       u32;
 typedef unsigned long long u64;
 
+typedef int                i32;
+typedef long long          i64;
+
 typedef float              f32;
 typedef double             f64;
 
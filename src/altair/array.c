@@ -57,6 +57,25 @@ void* ResizeArray_(void* array, u64 new_size) {
     return (void*)(header + ARRAY_END);
 }
 
+void* AL_CloneArray(const void* array) {
+    if (!array) {
+        LERROR("Cannot clone null array.");
+        return NULL;
+    }
+
+    const u64* header = HEADER_(array);
+    u64        bytes  = ARRAY_END * sizeof(u64) + header[ARRAY_CAPACITY] * header[ARRAY_STRIDE];
+
+    u64*       clone  = malloc(bytes);
+    if (!clone) {
+        LERROR("Could not allocate %lluB for array clone.", bytes);
+        return NULL;
+    }
+
+    memcpy(clone, header, bytes);
+    return (void*)(clone + ARRAY_END);
+}
+
 void AL_Free(void* array) {
     if (!array) return;
 
@@ -80,6 +99,22 @@ void AL_Remove(void* array, u64 index) {
     header[ARRAY_SIZE] -= 1;
 }
 
+void AL_SwapRemove(void* array, u64 index) {
+    if (!array) {
+        LERROR("Cannot remove from null array.");
+        return;
+    }
+
+    assert(index < AL_Size(array));
+
+    u64* header = HEADER_(array);
+    u64  stride = header[ARRAY_STRIDE];
+    u64  last   = header[ARRAY_SIZE] - 1;
+
+    if (index != last) memcpy((u8*)array + index * stride, (u8*)array + last * stride, stride);
+    header[ARRAY_SIZE] -= 1;
+}
+
 void AL_Clear(void* array) {
     if (!array) {
         LERROR("Cannon clear null array.");
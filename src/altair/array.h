@@ -21,8 +21,10 @@ enum {
 
 ALAPI void* CreateArray_(u64 stride, u64 count);
 ALAPI void* ResizeArray_(void* array, u64 new_size);
+ALAPI void* AL_CloneArray(const void* array);
 
 ALAPI void  AL_Remove(void* array, u64 index);
+ALAPI void  AL_SwapRemove(void* array, u64 index); // O(1), moves the last element into 'index'
 ALAPI void  AL_Free(void* array);
 ALAPI void  AL_Clear(void* array);
 
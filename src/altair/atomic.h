@@ -0,0 +1,30 @@
+#ifndef AL_ATOMIC_H_
+#define AL_ATOMIC_H_
+
+#include "aldefs.h"
+
+// thin wrappers over the GCC/clang '__atomic' builtins; the library is built as C99,
+// so <stdatomic.h> is not available
+
+#define AL_RELAXED __ATOMIC_RELAXED
+#define AL_ACQUIRE __ATOMIC_ACQUIRE
+#define AL_RELEASE __ATOMIC_RELEASE
+#define AL_ACQ_REL __ATOMIC_ACQ_REL
+#define AL_SEQ_CST __ATOMIC_SEQ_CST
+
+#define AL_AtomicLoad(ptr, order)            __atomic_load_n(ptr, order)
+
+#define AL_AtomicStore(ptr, value, order)    __atomic_store_n(ptr, value, order)
+
+#define AL_AtomicExchange(ptr, value, order) __atomic_exchange_n(ptr, value, order)
+
+#define AL_AtomicAdd(ptr, value, order)      __atomic_add_fetch(ptr, value, order)
+
+#define AL_AtomicSub(ptr, value, order)      __atomic_sub_fetch(ptr, value, order)
+
+#define AL_AtomicCompareExchange(ptr, pexpected, desired, order)                                   \
+    __atomic_compare_exchange_n(ptr, pexpected, desired, false, order, AL_RELAXED)
+
+#define AL_AtomicFence(order) __atomic_thread_fence(order)
+
+#endif
@@ -0,0 +1,33 @@
+#include "../../aldefs.h"
+#if defined(AL_PLATFORM_UNIX)
+
+#    include <errno.h>
+#    include <time.h>
+
+#    include "../../clock.h"
+#    include "../../coroutine.h"
+
+u64 AL_GetTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * AL_NS_PER_S + (u64)now.tv_nsec;
+}
+
+// the last timer tick's reading of the same clock
+u64 AL_GetCoarseTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return (u64)now.tv_sec * AL_NS_PER_S + (u64)now.tv_nsec;
+}
+
+void AL_SleepUntil(u64 deadline_ns) {
+    if (AL_InCoroutine()) return AL_SuspendUntil(deadline_ns);
+
+    struct timespec deadline = { .tv_sec  = deadline_ns / AL_NS_PER_S,
+                                 .tv_nsec = deadline_ns % AL_NS_PER_S };
+
+    // absolute, so signals don't stretch the wait
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+}
+
+#endif
@@ -0,0 +1,437 @@
+#include "../../aldefs.h"
+#if defined(AL_PLATFORM_UNIX)
+
+#    include <assert.h>
+#    include <limits.h>
+#    include <malloc.h>
+#    include <poll.h>
+#    include <pthread.h>
+#    include <stdint.h>
+#    include <sys/mman.h>
+#    include <ucontext.h>
+#    include <unistd.h>
+
+#    include "../../atomic.h"
+#    include "../../clock.h"
+#    include "../../coroutine.h"
+#    include "../../log.h"
+
+// swapcontext saves and restores the signal mask, a syscall per switch; on x86-64 a switch
+// only moves the callee-saved registers. sanitizers need to see the switches, so they get
+// the ucontext one.
+#    if defined(__x86_64__) && !defined(__SANITIZE_ADDRESS__)
+#        define UNIX_COROUTINE_SWITCH
+#    endif
+
+#    define UNIX_PARKING_BUCKETS 64 // power of two
+
+typedef struct {
+#    if defined(UNIX_COROUTINE_SWITCH)
+    void*             context; // its stack pointer, as saved by the switch
+    void*             caller;  // that of whoever resumed it last
+#    else
+    ucontext_t        context;
+    ucontext_t        caller;
+#    endif
+    u8*               stack; // the mapping, guard page first
+    PFN_thread_proc_t proc;
+    b8                started;
+} UnixCoroutineInternal;
+
+// a coroutine parked on a word, in a wait that lives on its stack
+typedef struct UnixParked_ {
+    u32*                word;
+    AL_Coroutine*       coroutine;
+    struct UnixParked_* next;
+} UnixParked;
+
+static AL_THREAD_LOCAL AL_Coroutine* s_current = NULL;
+
+// stack pool
+
+static pthread_mutex_t s_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static u8*             s_pool[AL_COROUTINE_POOL_SIZE];
+static u32             s_pooled    = 0;
+
+static u64             s_GuardSize(void) { return (u64)sysconf(_SC_PAGESIZE); }
+
+static u8*             s_TakeStack(void) {
+    u8* stack = NULL;
+
+    pthread_mutex_lock(&s_pool_lock);
+    if (s_pooled) stack = s_pool[--s_pooled];
+    pthread_mutex_unlock(&s_pool_lock);
+
+    if (stack) return stack;
+
+    // reserved, not committed, so thousands of mostly idle stacks stay cheap
+    u64 guard = s_GuardSize();
+    stack     = mmap(
+        NULL, guard + AL_COROUTINE_STACK_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0
+    );
+    if (stack == MAP_FAILED) return NULL;
+
+    // the stack grows down, so an overflow faults here instead of corrupting the next mapping
+    if (mprotect(stack, guard, PROT_NONE) != 0) {
+        munmap(stack, guard + AL_COROUTINE_STACK_SIZE);
+        return NULL;
+    }
+
+    return stack;
+}
+
+static void s_GiveStack(u8* stack) {
+    b8 pooled = false;
+
+    pthread_mutex_lock(&s_pool_lock);
+    if (s_pooled < AL_COROUTINE_POOL_SIZE) {
+        s_pool[s_pooled++] = stack;
+        pooled             = true;
+    }
+    pthread_mutex_unlock(&s_pool_lock);
+
+    if (!pooled) munmap(stack, s_GuardSize() + AL_COROUTINE_STACK_SIZE);
+}
+
+// context switches
+
+#    if defined(UNIX_COROUTINE_SWITCH)
+
+// pushes the callee-saved registers and the SSE and x87 control words, stores the stack
+// pointer in 'from', and pops the same off 'to' before returning on it
+__attribute__((visibility("hidden"))) void AL_SwitchStack(void** from, void* to);
+
+__asm__(".text\n"
+        ".globl AL_SwitchStack\n"
+        ".hidden AL_SwitchStack\n"
+        ".type AL_SwitchStack, @function\n"
+        "AL_SwitchStack:\n"
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    subq $8, %rsp\n"
+        "    stmxcsr (%rsp)\n"
+        "    fnstcw 4(%rsp)\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq %rsi, %rsp\n"
+        "    ldmxcsr (%rsp)\n"
+        "    fldcw 4(%rsp)\n"
+        "    addq $8, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n"
+        ".size AL_SwitchStack, .-AL_SwitchStack\n");
+
+// the first switch onto a stack returns here; it is never returned from
+static void s_Start(void) {
+    AL_Coroutine*          coroutine = s_current;
+    UnixCoroutineInternal* internals = coroutine->internals;
+
+    internals->proc(coroutine->user_context);
+
+    coroutine->finished = true;
+    AL_SwitchStack(&internals->context, internals->caller);
+}
+
+// lays out what the first switch pops: the default control words, zeroed registers, then
+// s_Start as the return address, aligned as if it had been called
+static void s_Prepare(AL_Coroutine* coroutine) {
+    UnixCoroutineInternal* internals = coroutine->internals;
+    u64* top   = (u64*)(internals->stack + s_GuardSize() + AL_COROUTINE_STACK_SIZE);
+    u64* frame = top - 9;
+
+    frame[0]   = 0x1F80 | (0x037Full << 32); // MXCSR, then the x87 control word
+    for (u32 i = 1; i < 7; ++i) frame[i] = 0;
+    frame[7]           = (u64)(uintptr_t)s_Start;
+    frame[8]           = 0;
+
+    internals->context = frame;
+}
+
+static void s_SwitchIn(UnixCoroutineInternal* internals) {
+    AL_SwitchStack(&internals->caller, internals->context);
+}
+
+static void s_SwitchOut(UnixCoroutineInternal* internals) {
+    AL_SwitchStack(&internals->context, internals->caller);
+}
+
+#    else
+
+// makecontext only passes ints, so the coroutine comes in halves
+static void s_Entry(u32 high, u32 low) {
+    AL_Coroutine*          coroutine = (AL_Coroutine*)(((uintptr_t)high << 32) | low);
+    UnixCoroutineInternal* internals = coroutine->internals;
+
+    internals->proc(coroutine->user_context);
+
+    coroutine->finished = true;
+    setcontext(&internals->caller);
+}
+
+static void s_Prepare(AL_Coroutine* coroutine) {
+    UnixCoroutineInternal* internals = coroutine->internals;
+
+    getcontext(&internals->context);
+    internals->context.uc_stack.ss_sp   = internals->stack + s_GuardSize();
+    internals->context.uc_stack.ss_size = AL_COROUTINE_STACK_SIZE;
+    internals->context.uc_link          = NULL;
+
+    uintptr_t address                   = (uintptr_t)coroutine;
+    makecontext(
+        &internals->context, (void (*)(void))s_Entry, 2, (u32)(address >> 32), (u32)address
+    );
+}
+
+static void s_SwitchIn(UnixCoroutineInternal* internals) {
+    swapcontext(&internals->caller, &internals->context);
+}
+
+static void s_SwitchOut(UnixCoroutineInternal* internals) {
+    swapcontext(&internals->context, &internals->caller);
+}
+
+#    endif
+
+// parking lot, by word address
+
+static pthread_mutex_t s_lot_lock = PTHREAD_MUTEX_INITIALIZER;
+static UnixParked*     s_lot[UNIX_PARKING_BUCKETS]; // atomic heads, so a wake can skip the lock
+
+static UnixParked**    s_Bucket(const u32* word) {
+    return s_lot + ((((uintptr_t)word >> 2) * 0x9E3779B97F4A7C15ull >> 32) &
+                    (UNIX_PARKING_BUCKETS - 1));
+}
+
+static void s_Park(UnixParked* parked) {
+    UnixParked** bucket = s_Bucket(parked->word);
+
+    pthread_mutex_lock(&s_lot_lock);
+    parked->next = *bucket;
+    AL_AtomicStore(bucket, parked, AL_SEQ_CST);
+    pthread_mutex_unlock(&s_lot_lock);
+}
+
+// a no-op if a wake took it off already
+static void s_Unpark(UnixParked* parked) {
+    UnixParked** link = s_Bucket(parked->word);
+
+    pthread_mutex_lock(&s_lot_lock);
+    while (*link && *link != parked) link = &(*link)->next;
+    if (*link) AL_AtomicStore(link, parked->next, AL_RELAXED);
+    pthread_mutex_unlock(&s_lot_lock);
+}
+
+void AL_WakeParked(u32* word) {
+    UnixParked** link = s_Bucket(word);
+
+    // either the waker sees the parked wait here, or the waiter sees the word's new value
+    if (!AL_AtomicLoad(link, AL_SEQ_CST)) return;
+
+    pthread_mutex_lock(&s_lot_lock);
+
+    while (*link) {
+        UnixParked* parked = *link;
+        if (parked->word != word) {
+            link = &parked->next;
+            continue;
+        }
+
+        // taken off before the hook runs, so the coroutine may resume and return right away
+        AL_AtomicStore(link, parked->next, AL_RELAXED);
+        parked->coroutine->on_wake(parked->coroutine->user_context);
+    }
+
+    pthread_mutex_unlock(&s_lot_lock);
+}
+
+// coroutines
+
+b8 AL_CreateCoroutine(PFN_thread_proc_t proc, void* user_context, AL_Coroutine* coroutine) {
+    if (!proc || !coroutine) {
+        LERROR("Cannot create a coroutine without a proc.");
+        return false;
+    }
+
+    UnixCoroutineInternal* internals = malloc(sizeof(UnixCoroutineInternal));
+    if (!internals) return false;
+
+    internals->stack = s_TakeStack();
+    if (!internals->stack) {
+        LERROR("Could not map a coroutine stack.");
+        free(internals);
+        return false;
+    }
+
+    internals->proc    = proc;
+    internals->started = false;
+
+    *coroutine         = (AL_Coroutine){ .internals    = internals,
+                                         .user_context = user_context,
+                                         .wake_ns      = 0,
+                                         .finished     = false,
+                                         .stopping     = false,
+                                         .on_wake      = NULL,
+                                         .reactor      = NULL };
+
+    s_Prepare(coroutine);
+    return true;
+}
+
+void AL_DestroyCoroutine(AL_Coroutine* coroutine) {
+    if (!coroutine || !coroutine->internals) return;
+    UnixCoroutineInternal* internals = coroutine->internals;
+
+    s_GiveStack(internals->stack);
+    free(internals);
+    coroutine->internals = NULL;
+}
+
+b8 AL_ResumeCoroutine(AL_Coroutine* coroutine) {
+    if (coroutine->finished) return false;
+
+    UnixCoroutineInternal* internals = coroutine->internals;
+    AL_Coroutine*          outer     = s_current;
+
+    internals->started               = true;
+    coroutine->wake_ns               = 0;
+    s_current                        = coroutine;
+
+    s_SwitchIn(internals);
+
+    s_current = outer;
+    return !coroutine->finished;
+}
+
+b8 AL_StopCoroutine(AL_Coroutine* coroutine, u32 timeout_ms) {
+    UnixCoroutineInternal* internals = coroutine->internals;
+    coroutine->stopping              = true;
+
+    if (!internals->started) {
+        coroutine->finished = true;
+        return true;
+    }
+
+    u64 deadline = AL_GetTime() + (u64)timeout_ms * AL_NS_PER_MS;
+    while (AL_ResumeCoroutine(coroutine)) {
+        if (AL_GetTime() >= deadline) return false;
+    }
+
+    return true;
+}
+
+void AL_SuspendUntil(u64 wake_ns) {
+    AL_Coroutine* coroutine = s_current;
+    if (!coroutine) return LERROR("Cannot suspend outside a coroutine.");
+
+    UnixCoroutineInternal* internals = coroutine->internals;
+    coroutine->wake_ns               = coroutine->stopping ? 0 : wake_ns;
+
+    s_SwitchOut(internals);
+}
+
+// the next check of a polled wait, backing off up to AL_COROUTINE_POLL_MS
+static u64 s_NextCheck(u64 now, u64 deadline, u64* interval) {
+    u64 wake  = now + *interval < deadline ? now + *interval : deadline;
+    *interval = *interval * 2 < AL_COROUTINE_POLL_MS * AL_NS_PER_MS
+                    ? *interval * 2
+                    : AL_COROUTINE_POLL_MS * AL_NS_PER_MS;
+    return wake;
+}
+
+static u64 s_Deadline(u32 timeout_ms) {
+    return timeout_ms == AL_TIMEOUT_MAX ? UINT64_MAX
+                                        : AL_GetTime() + (u64)timeout_ms * AL_NS_PER_MS;
+}
+
+b8 AL_SuspendWhile(u32* word, u32 value, u32 timeout_ms) {
+    AL_Coroutine* coroutine = s_current;
+    assert(coroutine != NULL);
+
+    u64        deadline = s_Deadline(timeout_ms);
+    u64        interval = AL_NS_PER_MS;
+    b8         parks    = coroutine->on_wake != NULL;
+    UnixParked parked   = { .word = word, .coroutine = coroutine, .next = NULL };
+
+    for (;;) {
+        // parked before the check, so a wake after it can't be missed
+        if (parks) s_Park(&parked);
+
+        b8  changed = AL_AtomicLoad(word, AL_SEQ_CST) != value;
+        u64 now     = AL_GetTime();
+        if (changed || now >= deadline) {
+            if (parks) s_Unpark(&parked);
+            return changed;
+        }
+
+        // a parked wait without a timeout has a deadline of AL_COROUTINE_PARKED
+        AL_SuspendUntil(parks ? deadline : s_NextCheck(now, deadline, &interval));
+        if (parks) s_Unpark(&parked);
+
+        // a stopping coroutine still suspends once, so whoever stops it keeps control
+        if (coroutine->stopping) return AL_AtomicLoad(word, AL_ACQUIRE) != value;
+    }
+}
+
+b8 AL_InCoroutine(void) { return s_current != NULL; }
+
+// resumes the coroutine waiting on the descriptor; the reactor disarms it after this call
+static void s_OnFdReady(i32 fd, u32 events, void* user_context) {
+    (void)fd;
+    (void)events;
+
+    AL_Coroutine* coroutine = user_context;
+    coroutine->on_wake(coroutine->user_context);
+}
+
+static u32 s_ToReactor(i32 events) {
+    u32 mask = REACTOR_ONCE;
+
+    if (events & POLLIN) mask |= REACTOR_READ;
+    if (events & POLLOUT) mask |= REACTOR_WRITE;
+
+    return mask;
+}
+
+i32 AL_WaitFd(i32 fd, i32 events, u32 timeout_ms) {
+    struct pollfd poller    = { .fd = fd, .events = (short)events, .revents = 0 };
+    AL_Coroutine* coroutine = s_current;
+
+    if (!coroutine) {
+        i32 ready = poll(&poller, 1, timeout_ms > INT_MAX ? -1 : (int)timeout_ms);
+        return ready < 0 ? -1 : ready ? poller.revents : 0;
+    }
+
+    u64 deadline = s_Deadline(timeout_ms);
+    u64 interval = AL_NS_PER_MS;
+    b8  parks    = coroutine->reactor && coroutine->on_wake;
+
+    for (;;) {
+        i32 ready = poll(&poller, 1, 0);
+        if (ready != 0) return ready < 0 ? -1 : poller.revents;
+
+        u64 now = AL_GetTime();
+        if (now >= deadline) return 0;
+
+        // a descriptor the reactor refuses is polled instead
+        b8 watched = parks &&
+                     AL_WatchFd(coroutine->reactor, fd, s_ToReactor(events), s_OnFdReady, coroutine);
+        parks      = watched;
+
+        // a wake from the reactor before the switch re-queues the task, so it isn't lost
+        AL_SuspendUntil(watched ? deadline : s_NextCheck(now, deadline, &interval));
+        if (watched) AL_UnwatchFd(coroutine->reactor, fd);
+
+        if (coroutine->stopping) deadline = 0;
+    }
+}
+
+#endif
@@ -2,13 +2,63 @@
 #if defined(AL_PLATFORM_UNIX)
 
 #    include <dlfcn.h>
+#    include <fcntl.h>
+#    include <link.h>
 #    include <malloc.h>
+#    include <stdio.h>
+#    include <stdlib.h>
+#    include <sys/mman.h>
+#    include <sys/sendfile.h>
+#    include <sys/stat.h>
 
 #    include "../../array.h"
 #    include "../../dll.h"
 #    include "../../hash.h"
 #    include "../../log.h"
 #    include "../../string.h"
+#    include "../../trace.h"
+
+// bounds-checked walk of the section headers; false if the file is not a native ELF object
+static b8 s_FindSection(
+    const u8* file, u64 length, const char* name, void* data, u64 size, u64* read
+) {
+    const ElfW(Ehdr)* header = (const ElfW(Ehdr)*)file;
+    u8                class  = sizeof(void*) == 8 ? ELFCLASS64 : ELFCLASS32;
+
+    if (length < sizeof(ElfW(Ehdr)) || memcmp(header->e_ident, ELFMAG, SELFMAG) != 0) return false;
+    if (header->e_ident[EI_CLASS] != class || header->e_shentsize != sizeof(ElfW(Shdr)))
+        return false;
+
+    u64 count = header->e_shnum;
+    if (header->e_shoff > length || count > (length - header->e_shoff) / sizeof(ElfW(Shdr)))
+        return false;
+    if (count == 0) return true;
+    if (header->e_shstrndx >= count) return false;
+
+    const ElfW(Shdr)* sections = (const ElfW(Shdr)*)(file + header->e_shoff);
+    const ElfW(Shdr)* strings  = sections + header->e_shstrndx;
+    if (strings->sh_offset > length || strings->sh_size > length - strings->sh_offset) return false;
+
+    const char* names  = (const char*)file + strings->sh_offset;
+    u64         needed = strlen(name) + 1;
+
+    for (u64 i = 0; i < count; ++i) {
+        const ElfW(Shdr)* section = sections + i;
+        if (section->sh_name >= strings->sh_size) continue;
+        if (strings->sh_size - section->sh_name < needed) continue;
+        if (memcmp(names + section->sh_name, name, needed) != 0) continue;
+
+        if (section->sh_type == SHT_NOBITS || section->sh_offset > length ||
+            section->sh_size > length - section->sh_offset)
+            return false;
+
+        *read = section->sh_size < size ? section->sh_size : size;
+        memcpy(data, file + section->sh_offset, *read);
+        return true;
+    }
+
+    return true;
+}
 
 b8 AL_LoadDLL(const char* filepath, AL_DLL* dll) {
     if (!filepath) {
@@ -21,7 +71,79 @@ b8 AL_LoadDLL(const char* filepath, AL_DLL* dll) {
         return false;
     }
 
+    u64   begin  = AL_TraceBegin();
     void* handle = dlopen(filepath, RTLD_LAZY);
+    if (begin) AL_TraceEnd("load dll", FNV_1A_C(filepath, strlen(filepath)), begin);
+
+    if (!handle) {
+        LERROR("Null library handle; cannot load DLL '%s'.\ndlerror: %s", filepath, dlerror());
+        return false;
+    }
+
+    dll->filepath       = AL_CopyC(filepath, strlen(filepath));
+    dll->handle         = handle;
+    dll->loaded_symbols = AL_Array(AL_Symbol, 0);
+
+    return true;
+}
+
+b8 AL_LoadDLLCopy(const char* filepath, PFN_dll_check_t check, void* user_context, AL_DLL* dll) {
+    if (!filepath) {
+        LERROR("Invalid library filepath; loading failed.");
+        return false;
+    }
+
+    if (!dll) {
+        LERROR("Null DLL output pointer; failed to load DLL '%s'.", filepath);
+        return false;
+    }
+
+    u64 begin  = AL_TraceBegin();
+    int source = open(filepath, O_RDONLY | O_CLOEXEC);
+    if (source == -1) {
+        LERROR("Cannot open DLL '%s' for copying.", filepath);
+        return false;
+    }
+
+    struct stat info;
+    char        copy_path[] = "/tmp/altair-XXXXXX.so";
+    int         copy        = mkstemps(copy_path, 3);
+
+    if (copy == -1 || fstat(source, &info) == -1) {
+        LERROR("Cannot create a private copy of DLL '%s'.", filepath);
+        if (copy != -1) {
+            close(copy);
+            unlink(copy_path);
+        }
+
+        close(source);
+        return false;
+    }
+
+    off_t offset = 0;
+    while (offset < info.st_size) {
+        if (sendfile(copy, source, &offset, info.st_size - offset) <= 0) break;
+    }
+
+    close(source);
+    close(copy);
+
+    if (offset != info.st_size) {
+        LERROR("Could not copy DLL '%s' to '%s'.", filepath, copy_path);
+        unlink(copy_path);
+        return false;
+    }
+
+    if (check && !check(copy_path, user_context)) {
+        unlink(copy_path);
+        return false;
+    }
+
+    // the mapping keeps the file alive, nothing is left behind in /tmp
+    void* handle = dlopen(copy_path, RTLD_LAZY | RTLD_LOCAL);
+    unlink(copy_path);
+    if (begin) AL_TraceEnd("load dll copy", FNV_1A_C(filepath, strlen(filepath)), begin);
+
     if (!handle) {
         LERROR("Null library handle; cannot load DLL '%s'.\ndlerror: %s", filepath, dlerror());
         return false;
@@ -69,18 +191,54 @@ AL_Symbol* AL_LoadSymbol(AL_DLL* dll, const char* symname, b8 required) {
     AL_Symbol* existing = AL_FindSymbol(dll, symname, false);
     if (existing) return existing;
 
-    void* addr = dlsym(dll->handle, symname);
+    u64   begin = AL_TraceBegin();
+    void* addr  = dlsym(dll->handle, symname);
+    if (begin) AL_TraceEnd("load symbol", FNV_1A(dll->filepath), begin);
+
     if (!addr) {
         if (required) LERROR("Symbol '%s' not found within library '%s'.", symname, dll->filepath);
         return NULL;
     }
 
-    AL_Symbol symbol = { .addr = addr, .symname = AL_CopyC(symname, strlen(symname)) };
+    // keyed by the name's hash, which AL_FindSymbol compares
+    AL_Symbol symbol             = { .addr = addr, .symname = AL_CopyC(symname, strlen(symname)) };
+    *AL_Metadata(symbol.symname) = FNV_1A_C(symname, strlen(symname));
     AL_Append(dll->loaded_symbols, symbol);
 
     return AL_Last(dll->loaded_symbols);
 }
 
+b8 AL_ReadSection(const char* filepath, const char* name, void* data, u64 size, u64* read) {
+    if (!filepath || !name || !read) {
+        LERROR("Cannot read a library section with a null filepath, name or output.");
+        return false;
+    }
+
+    *read    = 0;
+    int file = open(filepath, O_RDONLY | O_CLOEXEC);
+    if (file == -1) {
+        LERROR("Cannot open library '%s' to read its sections.", filepath);
+        return false;
+    }
+
+    struct stat info;
+    void*       mapping = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+        mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (mapping == MAP_FAILED) {
+        LERROR("Cannot map library '%s' to read its sections.", filepath);
+        return false;
+    }
+
+    b8 valid = s_FindSection(mapping, info.st_size, name, data, size, read);
+    munmap(mapping, info.st_size);
+
+    if (!valid) LERROR("Library '%s' is not a valid ELF object.", filepath);
+    return valid;
+}
+
 AL_Symbol* AL_FindSymbol(AL_DLL* dll, const char* symname, b8 required) {
     if (!dll) {
         LERROR("Cannot find symbol from null DLL.");
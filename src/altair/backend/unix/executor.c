@@ -0,0 +1,556 @@
+#include "../../aldefs.h"
+#if defined(AL_PLATFORM_UNIX)
+
+#    include <assert.h>
+#    include <malloc.h>
+#    include <pthread.h>
+#    include <stdlib.h>
+#    include <time.h>
+
+#    include "../../array.h"
+#    include "../../atomic.h"
+#    include "../../clock.h"
+#    include "../../epoch.h"
+#    include "../../executor.h"
+#    include "../../log.h"
+#    include "../../threads.h"
+#    include "../../trace.h"
+
+// idle workers poll this many times before sleeping, so back to back frames don't pay a wake-up
+#    define UNIX_EXECUTOR_SPIN 4096
+
+enum {
+    UNIX_TASK_IDLE = 0,
+    UNIX_TASK_QUEUED,
+    UNIX_TASK_RUNNING,
+    UNIX_TASK_PARKED, // off the queue until woken
+};
+
+typedef struct {
+    u64 begin;
+    u64 end;
+} UnixRange;
+
+// Chase-Lev deque; the owner pushes and pops at the bottom, thieves take from the top
+typedef struct {
+    i64       top; // atomic
+    u8        padding[AL_CACHE_LINE - sizeof(i64)];
+    i64       bottom; // atomic
+    UnixRange ranges[AL_EXECUTOR_DEQUE_SIZE];
+} UnixDeque;
+
+struct UnixExecutorInternal_;
+
+typedef struct {
+    UnixDeque                     deque;
+    pthread_t                     pid;
+    struct UnixExecutorInternal_* executor;
+    u32                           index;
+    u32                           seed; // victim selection
+} __attribute__((aligned(AL_CACHE_LINE))) UnixWorker;
+
+typedef struct UnixExecutorInternal_ {
+    UnixWorker*         workers; // [0] belongs to whichever thread is calling AL_ExecuteFor
+    u32                 count;   // including [0]
+
+    pthread_mutex_t     submit; // serializes callers
+    pthread_mutex_t     lock;
+    pthread_cond_t      wake;
+    pthread_cond_t      settled;    // a cancelled task's run returned
+    u64                 generation; // atomic, bumped per job
+    b8                  stop;       // atomic
+
+    AL_Task**           tasks;  // array, min-heap by due time, then order; guarded by 'lock'
+    u64                 queued; // atomic, size of 'tasks', polled by spinning workers
+    u64                 orders; // guarded by 'lock'
+
+    PFN_parallel_proc_t proc;
+    void*               user_context;
+    u64                 grain;
+    u64                 pending; // atomic, indices not yet finished
+} UnixExecutorInternal;
+
+static b8 s_Push(UnixDeque* deque, UnixRange range) {
+    i64 bottom = AL_AtomicLoad(&deque->bottom, AL_RELAXED);
+    i64 top    = AL_AtomicLoad(&deque->top, AL_ACQUIRE);
+    if (bottom - top >= AL_EXECUTOR_DEQUE_SIZE) return false;
+
+    UnixRange* slot = deque->ranges + (bottom & (AL_EXECUTOR_DEQUE_SIZE - 1));
+    AL_AtomicStore(&slot->begin, range.begin, AL_RELAXED);
+    AL_AtomicStore(&slot->end, range.end, AL_RELAXED);
+    AL_AtomicStore(&deque->bottom, bottom + 1, AL_RELEASE);
+    return true;
+}
+
+static b8 s_Pop(UnixDeque* deque, UnixRange* range) {
+    i64 bottom = AL_AtomicLoad(&deque->bottom, AL_RELAXED) - 1;
+    AL_AtomicStore(&deque->bottom, bottom, AL_RELAXED);
+    AL_AtomicFence(AL_SEQ_CST);
+    i64 top = AL_AtomicLoad(&deque->top, AL_RELAXED);
+
+    if (top > bottom) {
+        AL_AtomicStore(&deque->bottom, bottom + 1, AL_RELAXED);
+        return false;
+    }
+
+    UnixRange* slot = deque->ranges + (bottom & (AL_EXECUTOR_DEQUE_SIZE - 1));
+    range->begin    = AL_AtomicLoad(&slot->begin, AL_RELAXED);
+    range->end      = AL_AtomicLoad(&slot->end, AL_RELAXED);
+    if (top < bottom) return true;
+
+    // last range; race the thieves for it
+    b8 won = AL_AtomicCompareExchange(&deque->top, &top, top + 1, AL_SEQ_CST);
+    AL_AtomicStore(&deque->bottom, bottom + 1, AL_RELAXED);
+    return won;
+}
+
+static b8 s_Steal(UnixDeque* deque, UnixRange* range) {
+    i64 top = AL_AtomicLoad(&deque->top, AL_ACQUIRE);
+    AL_AtomicFence(AL_SEQ_CST);
+    i64 bottom = AL_AtomicLoad(&deque->bottom, AL_ACQUIRE);
+    if (top >= bottom) return false;
+
+    UnixRange* slot = deque->ranges + (top & (AL_EXECUTOR_DEQUE_SIZE - 1));
+    range->begin    = AL_AtomicLoad(&slot->begin, AL_RELAXED);
+    range->end      = AL_AtomicLoad(&slot->end, AL_RELAXED);
+
+    return AL_AtomicCompareExchange(&deque->top, &top, top + 1, AL_SEQ_CST);
+}
+
+// indices of an AL_ExecuteFor job this thread is running; one that starts another job runs it
+// inline, since waiting for the pool would be waiting on itself
+static AL_THREAD_LOCAL u32 s_running = 0;
+
+static void s_RunRange(UnixWorker* worker, UnixRange range) {
+    UnixExecutorInternal* executor = worker->executor;
+
+    // lazy binary splitting; the pushed halves are what idle workers steal
+    while (range.end - range.begin > executor->grain) {
+        u64 middle = range.begin + (range.end - range.begin) / 2;
+        if (!s_Push(&worker->deque, (UnixRange){ .begin = middle, .end = range.end })) break;
+        range.end = middle;
+    }
+
+    s_running += 1;
+    for (u64 i = range.begin; i < range.end; ++i) executor->proc(i, executor->user_context);
+    s_running -= 1;
+
+    AL_AtomicSub(&executor->pending, range.end - range.begin, AL_RELEASE);
+}
+
+static b8 s_StealAny(UnixWorker* worker, UnixRange* range) {
+    UnixExecutorInternal* executor = worker->executor;
+
+    // xorshift; a random start spreads thieves over the victims
+    worker->seed ^= worker->seed << 13;
+    worker->seed ^= worker->seed >> 17;
+    worker->seed ^= worker->seed << 5;
+
+    for (u32 i = 0, start = worker->seed % executor->count; i < executor->count; ++i) {
+        u32 victim = (start + i) % executor->count;
+        if (victim == worker->index) continue;
+        if (s_Steal(&executor->workers[victim].deque, range)) return true;
+    }
+
+    return false;
+}
+
+// works on the current job until every index of it has finished
+static void s_Work(UnixWorker* worker) {
+    UnixExecutorInternal* executor = worker->executor;
+    UnixRange             range;
+
+    while (AL_AtomicLoad(&executor->pending, AL_ACQUIRE) > 0) {
+        if (s_Pop(&worker->deque, &range) || s_StealAny(worker, &range))
+            s_RunRange(worker, range);
+        else
+            AL_Yield();
+    }
+}
+
+// task queue, guarded by the executor's lock
+
+static b8 s_Before(const AL_Task* a, const AL_Task* b) {
+    if (a->due_ns != b->due_ns) return a->due_ns < b->due_ns;
+    return a->order < b->order;
+}
+
+static void s_Place(AL_Task** tasks, u64 index, AL_Task* task) {
+    tasks[index] = task;
+    task->index  = index;
+}
+
+static void s_SiftUp(AL_Task** tasks, u64 index) {
+    AL_Task* task = tasks[index];
+    while (index > 0 && s_Before(task, tasks[(index - 1) / 2])) {
+        s_Place(tasks, index, tasks[(index - 1) / 2]);
+        index = (index - 1) / 2;
+    }
+
+    s_Place(tasks, index, task);
+}
+
+static void s_SiftDown(AL_Task** tasks, u64 index) {
+    AL_Task* task  = tasks[index];
+    u64      count = AL_Size(tasks);
+
+    for (;;) {
+        u64 child = 2 * index + 1;
+        if (child >= count) break;
+        if (child + 1 < count && s_Before(tasks[child + 1], tasks[child])) child += 1;
+        if (!s_Before(tasks[child], task)) break;
+
+        s_Place(tasks, index, tasks[child]);
+        index = child;
+    }
+
+    s_Place(tasks, index, task);
+}
+
+static void s_Enqueue(UnixExecutorInternal* executor, AL_Task* task) {
+    task->state = UNIX_TASK_QUEUED;
+    task->order = executor->orders++;
+
+    AL_Append(executor->tasks, task);
+    s_SiftUp(executor->tasks, AL_Size(executor->tasks) - 1);
+    AL_AtomicStore(&executor->queued, AL_Size(executor->tasks), AL_RELAXED);
+}
+
+static void s_Dequeue(UnixExecutorInternal* executor, AL_Task* task) {
+    AL_Task** tasks = executor->tasks;
+    u64       index = task->index;
+    AL_Task*  last  = *AL_Last(tasks);
+
+    AL_Size(executor->tasks) -= 1;
+    AL_AtomicStore(&executor->queued, AL_Size(tasks), AL_RELAXED);
+    task->state = UNIX_TASK_IDLE;
+
+    if (last == task) return;
+    s_Place(tasks, index, last);
+    s_SiftUp(tasks, index);
+    s_SiftDown(tasks, last->index);
+}
+
+// the first task due, marked running, else null and 'wait_ns' how long until one is (0 if
+// none is queued)
+static AL_Task* s_TakeTask(UnixExecutorInternal* executor, u64* wait_ns) {
+    *wait_ns = 0;
+    if (AL_Size(executor->tasks) == 0) return NULL;
+
+    AL_Task* task = executor->tasks[0];
+    u64      now  = AL_GetTime();
+    if (task->due_ns > now) {
+        *wait_ns = task->due_ns - now;
+        return NULL;
+    }
+
+    s_Dequeue(executor, task);
+    task->state = UNIX_TASK_RUNNING;
+    return task;
+}
+
+// runs the task, then the continuations it hands on for as long as they are due and nothing
+// else is waiting
+static void s_RunTask(UnixExecutorInternal* executor, AL_Task* task) {
+    while (task) {
+        PFN_task_proc_t proc  = task->proc;
+        u64             begin = AL_TraceBegin();
+        AL_Task*        next  = proc(task);
+        AL_TraceEnd("task", (u64)proc, begin);
+
+        AL_Task* inline_next = NULL;
+        pthread_mutex_lock(&executor->lock);
+
+        task->state = UNIX_TASK_IDLE;
+        if (task->cancelled) pthread_cond_broadcast(&executor->settled);
+
+        // whatever it was waiting for happened while it ran
+        if (next == task && task->woken) next->due_ns = 0;
+        task->woken = false;
+
+        // the continuation may already be queued, or running elsewhere
+        if (next && !next->cancelled && next->state == UNIX_TASK_IDLE) {
+            u64 now        = AL_GetTime();
+            b8  contended  = AL_Size(executor->tasks) && executor->tasks[0]->due_ns <= now;
+            next->executor = executor;
+
+            if (next->due_ns == AL_TASK_PARKED) {
+                next->state = UNIX_TASK_PARKED;
+            } else if (next->due_ns <= now && !contended) {
+                next->state = UNIX_TASK_RUNNING;
+                inline_next = next;
+            } else {
+                s_Enqueue(executor, next);
+                pthread_cond_signal(&executor->wake);
+            }
+        }
+
+        pthread_mutex_unlock(&executor->lock);
+        task = inline_next;
+    }
+}
+
+static void s_WorkerLoop(UnixWorker* worker) {
+    UnixExecutorInternal* executor = worker->executor;
+    u64                   seen     = 0;
+
+    for (;;) {
+        u64 generation = seen;
+        for (u32 spin = 0; spin < UNIX_EXECUTOR_SPIN && generation == seen; ++spin) {
+            if (AL_AtomicLoad(&executor->stop, AL_ACQUIRE)) return;
+            if (AL_AtomicLoad(&executor->queued, AL_RELAXED)) break;
+            generation = AL_AtomicLoad(&executor->generation, AL_ACQUIRE);
+        }
+
+        // between jobs, queued tasks are run as they fall due
+        AL_Task* task = NULL;
+        if (generation == seen) {
+            pthread_mutex_lock(&executor->lock);
+
+            while (!executor->stop && executor->generation == seen) {
+                u64 wait_ns;
+                task = s_TakeTask(executor, &wait_ns);
+                if (task) break;
+
+                if (!wait_ns) {
+                    pthread_cond_wait(&executor->wake, &executor->lock);
+                    continue;
+                }
+
+                u64             due     = AL_GetTime() + wait_ns;
+                struct timespec timeout = { .tv_sec  = due / AL_NS_PER_S,
+                                            .tv_nsec = due % AL_NS_PER_S };
+                pthread_cond_timedwait(&executor->wake, &executor->lock, &timeout);
+            }
+
+            generation = executor->generation;
+            pthread_mutex_unlock(&executor->lock);
+        }
+
+        if (task) {
+            s_RunTask(executor, task);
+            continue;
+        }
+
+        if (AL_AtomicLoad(&executor->stop, AL_ACQUIRE)) return;
+
+        seen = generation;
+        s_Work(worker);
+    }
+}
+
+static void* s_WorkerProc(void* argument) {
+    s_WorkerLoop(argument);
+    AL_ReleaseTraceRing();
+    AL_ReleaseEpochReader();
+    return NULL;
+}
+
+b8 AL_CreateExecutor(u32 workers, AL_Executor* executor) {
+    if (!executor) {
+        LERROR("Cannot create a null executor.");
+        return false;
+    }
+
+    UnixExecutorInternal* internals = calloc(1, sizeof(UnixExecutorInternal));
+    if (!internals) {
+        LERROR("Could not allocate executor.");
+        return false;
+    }
+
+    internals->count = workers + 1;
+    if (posix_memalign(
+            (void**)&internals->workers, AL_CACHE_LINE, internals->count * sizeof(UnixWorker)
+        ) != 0) {
+        LERROR("Could not allocate %u executor workers.", workers);
+        free(internals);
+        return false;
+    }
+
+    internals->submit = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    internals->lock   = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    internals->tasks  = AL_Array(AL_Task*, 0);
+
+    // timed waits are on AL_GetTime's clock
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&internals->wake, &attributes);
+    pthread_cond_init(&internals->settled, &attributes);
+    pthread_condattr_destroy(&attributes);
+
+    for (u32 i = 0; i < internals->count; ++i) {
+        UnixWorker* worker   = internals->workers + i;
+        worker->deque.top    = 0;
+        worker->deque.bottom = 0;
+        worker->executor     = internals;
+        worker->index        = i;
+        worker->seed         = 2463534242u + i * 0x9e3779b9u;
+    }
+
+    executor->internals = internals;
+    executor->workers   = 0;
+
+    for (u32 i = 1; i < internals->count; ++i) {
+        UnixWorker* worker = internals->workers + i;
+        if (pthread_create(&worker->pid, NULL, s_WorkerProc, worker) != 0) {
+            LWARN("Could only launch %u of %u executor workers.", i - 1, workers);
+            break;
+        }
+
+        executor->workers += 1;
+    }
+
+    internals->count = executor->workers + 1;
+    return true;
+}
+
+void AL_DestroyExecutor(AL_Executor* executor) {
+    if (!executor || !executor->internals) return;
+    UnixExecutorInternal* internals = executor->internals;
+
+    pthread_mutex_lock(&internals->lock);
+    AL_AtomicStore(&internals->stop, true, AL_RELEASE);
+    pthread_cond_broadcast(&internals->wake);
+    pthread_mutex_unlock(&internals->lock);
+
+    for (u32 i = 1; i < internals->count; ++i) pthread_join(internals->workers[i].pid, NULL);
+
+    // dropped, but no longer queued
+    AL_ForEach(internals->tasks, i) internals->tasks[i]->state = UNIX_TASK_IDLE;
+    AL_Free(internals->tasks);
+
+    pthread_mutex_destroy(&internals->submit);
+    pthread_mutex_destroy(&internals->lock);
+    pthread_cond_destroy(&internals->wake);
+    pthread_cond_destroy(&internals->settled);
+
+    free(internals->workers);
+    free(internals);
+    executor->internals = NULL;
+    executor->workers   = 0;
+}
+
+void AL_ExecuteFor(AL_Executor* executor, u64 count, PFN_parallel_proc_t proc, void* user_context) {
+    if (!proc) return LERROR("Cannot execute a null parallel process.");
+    if (count == 0) return;
+
+    UnixExecutorInternal* internals = executor ? executor->internals : NULL;
+
+    // nothing to share the work with
+    if (!internals || internals->count == 1 || count == 1 || s_running) {
+        for (u64 i = 0; i < count; ++i) proc(i, user_context);
+        return;
+    }
+
+    pthread_mutex_lock(&internals->submit);
+
+    internals->proc         = proc;
+    internals->user_context = user_context;
+    internals->grain        = count / (4 * internals->count);
+    if (internals->grain == 0) internals->grain = 1;
+
+    AL_AtomicStore(&internals->pending, count, AL_RELEASE);
+
+    UnixWorker* caller = internals->workers;
+    s_Push(&caller->deque, (UnixRange){ .begin = 0, .end = count });
+
+    pthread_mutex_lock(&internals->lock);
+    AL_AtomicAdd(&internals->generation, 1, AL_RELEASE);
+    pthread_cond_broadcast(&internals->wake);
+    pthread_mutex_unlock(&internals->lock);
+
+    // the caller joins in, and returning means every index is done
+    s_Work(caller);
+
+    pthread_mutex_unlock(&internals->submit);
+}
+
+b8 AL_Submit(AL_Executor* executor, AL_Task* task) {
+    if (!task || !task->proc) {
+        LERROR("Cannot submit a null task.");
+        return false;
+    }
+
+    UnixExecutorInternal* internals = executor ? executor->internals : NULL;
+    if (!internals || internals->count == 1) {
+        LERROR("Cannot submit a task to an executor without workers.");
+        return false;
+    }
+
+    pthread_mutex_lock(&internals->lock);
+
+    b8 idle = task->executor == NULL || task->state == UNIX_TASK_IDLE;
+    if (idle) {
+        task->executor  = internals;
+        task->cancelled = false;
+        task->woken     = false;
+        s_Enqueue(internals, task);
+        pthread_cond_signal(&internals->wake);
+    }
+
+    pthread_mutex_unlock(&internals->lock);
+    return idle;
+}
+
+b8 AL_CancelTask(AL_Task* task, u32 timeout_ms) {
+    if (!task || !task->executor) return true;
+    UnixExecutorInternal* internals = task->executor;
+
+    u64                   due       = AL_GetTime() + (u64)timeout_ms * AL_NS_PER_MS;
+    struct timespec       timeout   = { .tv_sec = due / AL_NS_PER_S, .tv_nsec = due % AL_NS_PER_S };
+
+    pthread_mutex_lock(&internals->lock);
+
+    task->cancelled = true;
+    if (task->state == UNIX_TASK_QUEUED) s_Dequeue(internals, task);
+    if (task->state == UNIX_TASK_PARKED) task->state = UNIX_TASK_IDLE;
+
+    while (task->state == UNIX_TASK_RUNNING) {
+        if (timeout_ms == AL_TIMEOUT_MAX) {
+            pthread_cond_wait(&internals->settled, &internals->lock);
+            continue;
+        }
+
+        if (AL_GetTime() >= due) break;
+        pthread_cond_timedwait(&internals->settled, &internals->lock, &timeout);
+    }
+
+    b8 stopped = task->state != UNIX_TASK_RUNNING;
+    pthread_mutex_unlock(&internals->lock);
+    return stopped;
+}
+
+b8 AL_WakeTask(AL_Task* task) {
+    if (!task || !task->executor) return false;
+    UnixExecutorInternal* internals = task->executor;
+
+    pthread_mutex_lock(&internals->lock);
+
+    b8 woken = !task->cancelled;
+    if (woken) {
+        switch (task->state) {
+        case UNIX_TASK_QUEUED:
+            // due sooner, so it only moves up the heap
+            task->due_ns = 0;
+            s_SiftUp(internals->tasks, task->index);
+            pthread_cond_signal(&internals->wake);
+            break;
+
+        case UNIX_TASK_PARKED:
+            task->due_ns = 0;
+            s_Enqueue(internals, task);
+            pthread_cond_signal(&internals->wake);
+            break;
+
+        case UNIX_TASK_RUNNING: task->woken = true; break;
+
+        default: woken = false; break;
+        }
+    }
+
+    pthread_mutex_unlock(&internals->lock);
+    return woken;
+}
+
+#endif
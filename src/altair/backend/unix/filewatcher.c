@@ -7,11 +7,20 @@
 #    include <stdio.h>
 #    include <stdlib.h>
 #    include <sys/inotify.h>
+#    include <sys/stat.h>
+#    include <sys/timerfd.h>
+#    include <unistd.h>
 
 #    include "../../array.h"
+#    include "../../atomic.h"
+#    include "../../clock.h"
 #    include "../../filewatcher.h"
+#    include "../../hash.h"
+#    include "../../hashmap.h"
 #    include "../../log.h"
+#    include "../../reactor.h"
 #    include "../../threads.h"
+#    include "../../trace.h"
 
 static enum FileEvent s_TranslateFileEventType(u32 mask) {
     enum FileEvent type = FILE_INVALID;
@@ -32,17 +41,33 @@ typedef struct {
     u8        depth;
 } WatchDirectory;
 
+// events on one file, merged until it goes quiet
+typedef struct {
+    AL_String      directory; // owned by its watch
+    AL_String      file;
+    u64            hash;    // of the full path
+    u64            last_ns; // latest event, or size change
+    i64            size;    // -1 while the file is missing
+    u32            events;
+    enum FileEvent first; // event that opened the window
+} PendingEvent;
+
 typedef struct {
     WatchDirectory* watches;
+    PendingEvent*   pending; // in order of arrival
+    AL_HashMap      present; // path hashes of files handed out as added or modified, not removed
     u32             instance;
     u32             mask;
+    i32             timer; // timerfd, armed for the earliest window to close
 } UnixFileWatcherInternal;
 
-static u32  s_FileWatcherProc(void* argument);
+static void s_OnNotify(i32 fd, u32 events, void* argument);
+static void s_OnTimer(i32 fd, u32 events, void* argument);
 static void s_BuiltInDirectoryCallback(AL_String directory, AL_String file, void* argument);
 
 b8          AL_CreateFileWatcher(
-             const char* path, u8 max_depth, const char* filter, u64 update_ms, AL_FileWatcher* watcher
+             const char* path, u8 max_depth, const char* filter, AL_Reactor* reactor,
+             AL_FileWatcher* watcher
          ) {
     if (!path) {
         LERROR("Cannot create file watcher for a null path.");
@@ -54,6 +79,11 @@ b8          AL_CreateFileWatcher(
         return false;
     }
 
+    if (!reactor) {
+        LERROR("Cannot create a file watcher without a reactor.");
+        return false;
+    }
+
     u32 instance = inotify_init1(IN_NONBLOCK);
     if (instance == -1) {
         LERROR("Could not create new inotify instance for filewatcher.");
@@ -69,26 +99,37 @@ b8          AL_CreateFileWatcher(
         return false;
     }
 
+    i32 timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer == -1) {
+        LERROR("Could not create a timer for filewatcher.");
+        close(instance);
+        return false;
+    }
+
     watcher->internals                 = malloc(sizeof(UnixFileWatcherInternal));
     UnixFileWatcherInternal* internals = watcher->internals;
     internals->instance                = instance;
     internals->watches                 = AL_Array(WatchDirectory, 1);
+    internals->pending                 = AL_Array(PendingEvent, 0);
     internals->mask                    = mask;
+    AL_CreateHashMap(0, &internals->present);
+    internals->timer                   = timer;
 
     WatchDirectory watch               = { .directory = AL_CopyC(path, strlen(path)),
                                            .depth     = 1,
                                            .desc      = watch_descriptor };
     AL_Append(internals->watches, watch);
 
-    watcher->update_ms = update_ms;
+    watcher->reactor   = reactor;
+    watcher->mutex     = AL_CreateMutex();
     watcher->callbacks = AL_Array(AL_FileEventCallback, 3);
     watcher->filter    = filter ? filter : "*";
     watcher->max_depth = max_depth;
-
-    if (!AL_CreateThread((void*)s_FileWatcherProc, watcher, false, &watcher->thread)) {
-        LERROR("Could not create new thread process for filewatcher of path '%s'.", path);
-        return false;
-    }
+    watcher->quiet_ms  = AL_FILEWATCH_QUIET_MS;
+    watcher->events    = 0;
+    watcher->emitted   = 0;
+    watcher->coalesced = 0;
+    watcher->unsettled = 0;
 
     AL_AddFileCallback(watcher, s_BuiltInDirectoryCallback, FILE_DIRECTORY, watcher);
 
@@ -96,7 +137,13 @@ b8          AL_CreateFileWatcher(
     sprintf(command, "touch %s* >/dev/null 2>&1", path);
     system(command);
 
-    AL_StartThread(&watcher->thread);
+    // the events the touch queued are waiting already
+    if (!AL_WatchFd(reactor, instance, REACTOR_READ, s_OnNotify, watcher) ||
+        !AL_WatchFd(reactor, timer, REACTOR_READ, s_OnTimer, watcher)) {
+        LERROR("Could not hand the filewatcher of path '%s' to the reactor.", path);
+        return false;
+    }
+
     return true;
 }
 
@@ -106,26 +153,49 @@ b8 AL_DestroyFileWatcher(AL_FileWatcher* watcher) {
     assert(watcher->callbacks != NULL);
     assert(watcher->internals != NULL);
 
-    if (!AL_DestroyThread(&watcher->thread, AL_TIMEOUT_MAX)) {
-        LERROR("Could not destroy filewatcher thread process.");
+    UnixFileWatcherInternal* internals = watcher->internals;
+
+    // waits out a callback in flight
+    if (!AL_UnwatchFd(watcher->reactor, internals->instance) ||
+        !AL_UnwatchFd(watcher->reactor, internals->timer)) {
+        LERROR("Could not take the filewatcher off its reactor.");
         return false;
     }
 
-    UnixFileWatcherInternal* internals = watcher->internals;
-
     AL_ForEach(internals->watches, i) {
         WatchDirectory* watch = internals->watches + i;
         inotify_rm_watch(internals->instance, watch->desc);
         AL_Free(watch->directory);
     }
 
+    AL_ForEach(internals->pending, i) AL_Free(internals->pending[i].file);
+    AL_DestroyHashMap(&internals->present);
+
+    close(internals->timer);
+    close(internals->instance);
+
     AL_Free(internals->watches);
+    AL_Free(internals->pending);
     free(watcher->internals);
     AL_Free(watcher->callbacks);
+    AL_DestroyMutex(&watcher->mutex);
 
     return true;
 }
 
+void AL_SetQuietWindow(AL_FileWatcher* watcher, u64 quiet_ms) {
+    if (watcher) AL_AtomicStore(&watcher->quiet_ms, quiet_ms, AL_RELAXED);
+}
+
+void AL_GetFileWatcherStats(const AL_FileWatcher* watcher, AL_FileWatcherStats* stats) {
+    if (!watcher || !stats) return;
+
+    stats->events    = AL_AtomicLoad(&watcher->events, AL_RELAXED);
+    stats->emitted   = AL_AtomicLoad(&watcher->emitted, AL_RELAXED);
+    stats->coalesced = AL_AtomicLoad(&watcher->coalesced, AL_RELAXED);
+    stats->unsettled = AL_AtomicLoad(&watcher->unsettled, AL_RELAXED);
+}
+
 b8 AL_AddFileCallback(
     AL_FileWatcher* watcher, PFN_filewatch_callback_t callback, enum FileEvent event,
     void* user_context
@@ -153,7 +223,7 @@ b8 AL_AddFileCallback(
     AL_FileEventCallback fwcb = { .callback     = callback,
                                   .event        = event,
                                   .user_context = user_context };
-    ALSAFE(&watcher->thread.mutex, AL_Append(watcher->callbacks, fwcb););
+    ALSAFE(&watcher->mutex, AL_Append(watcher->callbacks, fwcb););
 
     return true;
 }
@@ -174,7 +244,7 @@ b8 AL_RemoveFileCallback(AL_FileWatcher* watcher, PFN_filewatch_callback_t callb
     AL_ForEach(watcher->callbacks, i) {
         AL_FileEventCallback* fwcb = watcher->callbacks + i;
         if (fwcb->callback == callback) {
-            ALSAFE(&watcher->thread.mutex, AL_Remove(watcher->callbacks, i););
+            ALSAFE(&watcher->mutex, AL_Remove(watcher->callbacks, i););
             return true;
         }
     }
@@ -219,35 +289,177 @@ void s_BuiltInDirectoryCallback(AL_String directory, AL_String file, void* argum
     system(command);
 }
 
-u32 s_FileWatcherProc(void* argument) {
-    if (!argument) {
-        LERROR("Filewatcher process launched with null internal argument.");
-        return 1;
+static void s_Dispatch(
+    AL_FileWatcher* watcher, AL_String directory, AL_String file, enum FileEvent mask
+) {
+    u64 begin = AL_TraceBegin();
+
+    AL_ForEach(watcher->callbacks, i) {
+        AL_FileEventCallback* fwcb = watcher->callbacks + i;
+        if (mask & fwcb->event) fwcb->callback(directory, file, fwcb->user_context);
     }
 
+    if (begin) {
+        u64 id = FNV_1A_C(file, strlen(file));
+        AL_TraceLabel(id, file);
+        AL_TraceEnd("file event", id, begin);
+    }
+}
+
+static i64 s_FileSize(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? info.st_size : -1;
+}
+
+// merges the event into its file's pending one, opening a window if there is none
+static void s_Coalesce(
+    AL_FileWatcher* watcher, AL_String directory, const char* name, enum FileEvent mask
+) {
+    UnixFileWatcherInternal* internals = watcher->internals;
+
+    char                     path[AL_MAX_PATH + 1];
+    snprintf(path, sizeof(path), "%s%s", directory, name);
+
+    u64           hash    = FNV_1A_C(path, strlen(path));
+    PendingEvent* pending = NULL;
+    AL_ForEach(internals->pending, i) {
+        if (internals->pending[i].hash == hash) pending = internals->pending + i;
+    }
+
+    if (!pending) {
+        PendingEvent event = { .directory = directory,
+                               .file      = AL_CopyC(name, strlen(name)),
+                               .hash      = hash,
+                               .first     = mask };
+        AL_Append(internals->pending, event);
+        pending = AL_Last(internals->pending);
+    }
+
+    pending->last_ns = AL_GetTime();
+    pending->size    = s_FileSize(path);
+    pending->events += 1;
+    AL_AtomicAdd(&watcher->events, 1, AL_RELAXED);
+}
+
+// hands out the merged event of every file that has been quiet for the window and kept its size
+static void s_FlushPending(AL_FileWatcher* watcher) {
+    UnixFileWatcherInternal* internals = watcher->internals;
+    u64                      quiet_ms  = AL_AtomicLoad(&watcher->quiet_ms, AL_RELAXED);
+    u64                      now       = AL_GetTime();
+    b8                       flushed   = false;
+
+    for (u64 i = 0; i < AL_Size(internals->pending);) {
+        PendingEvent* pending = internals->pending + i;
+        if (now - pending->last_ns < quiet_ms * AL_NS_PER_MS) {
+            ++i;
+            continue;
+        }
+
+        char path[AL_MAX_PATH + 1];
+        snprintf(path, sizeof(path), "%s%s", pending->directory, pending->file);
+
+        // still being written; wait out another window
+        i64 size = s_FileSize(path);
+        if (size != pending->size) {
+            pending->size    = size;
+            pending->last_ns = now;
+            AL_AtomicAdd(&watcher->unsettled, 1, AL_RELAXED);
+            ++i;
+            continue;
+        }
+
+        PendingEvent event = *pending;
+        AL_Remove(internals->pending, i);
+
+        // a file created and removed again within the window never existed, and one moved or
+        // created over a file already handed out replaces it, as builds install their outputs
+        u64            value;
+        b8             known = AL_HashMapFind(&internals->present, event.hash, &value);
+        enum FileEvent mask;
+        if (size < 0) mask = (event.first & FILE_ADDED) && !known ? FILE_INVALID : FILE_REMOVED;
+        else
+            mask = (event.first & FILE_ADDED) && !known ? FILE_ADDED : FILE_MODIFIED;
+
+        if (mask == FILE_REMOVED) AL_HashMapErase(&internals->present, event.hash);
+        else if (mask != FILE_INVALID)
+            AL_HashMapInsert(&internals->present, event.hash, 1);
+
+        if (mask != FILE_INVALID) {
+            flushed = true;
+            s_Dispatch(watcher, event.directory, event.file, mask);
+            AL_AtomicAdd(&watcher->emitted, 1, AL_RELAXED);
+            event.events -= 1;
+        }
+
+        AL_AtomicAdd(&watcher->coalesced, event.events, AL_RELAXED);
+        AL_Free(event.file);
+    }
+
+    // lets callbacks act on everything handed out in one go
+    if (!flushed) return;
+    AL_ForEach(watcher->callbacks, i) {
+        AL_FileEventCallback* fwcb = watcher->callbacks + i;
+        if (fwcb->event & FILE_FLUSHED) fwcb->callback(NULL, NULL, fwcb->user_context);
+    }
+}
+
+// sets the timer for the next run of windows to close, or disarms it if none is open
+static void s_ArmTimer(AL_FileWatcher* watcher) {
+    UnixFileWatcherInternal* internals = watcher->internals;
+    u64                      quiet_ms  = AL_AtomicLoad(&watcher->quiet_ms, AL_RELAXED);
+    u64                      quiet_ns  = quiet_ms * AL_NS_PER_MS;
+    u64                      deadline  = 0;
+
+    AL_ForEach(internals->pending, i) {
+        u64 closes = internals->pending[i].last_ns + quiet_ns;
+        if (!deadline || closes < deadline) deadline = closes;
+    }
+
+    // windows closing within another window of it are waited for too, so files written
+    // together, like a build's outputs, settle in one run
+    for (b8 extended = deadline != 0; extended;) {
+        extended = false;
+        AL_ForEach(internals->pending, i) {
+            u64 closes = internals->pending[i].last_ns + quiet_ns;
+            if (closes <= deadline || closes > deadline + quiet_ns) continue;
+
+            deadline = closes;
+            extended = true;
+        }
+    }
+
+    // absolute, on the clock AL_GetTime reads; a deadline already past fires right away
+    struct itimerspec timer = { .it_value = { .tv_sec  = deadline / AL_NS_PER_S,
+                                              .tv_nsec = deadline % AL_NS_PER_S } };
+    timerfd_settime(internals->timer, TFD_TIMER_ABSTIME, &timer, NULL);
+}
+
+static void s_OnTimer(i32 fd, u32 events, void* argument) {
+    (void)events;
+    AL_FileWatcher* watcher = argument;
+
+    u64             expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+
+    s_FlushPending(watcher);
+    s_ArmTimer(watcher);
+}
+
+static void s_OnNotify(i32 fd, u32 events, void* argument) {
+    (void)events;
     AL_FileWatcher*          watcher   = argument;
     UnixFileWatcherInternal* internals = watcher->internals;
 
     assert(watcher->internals != NULL);
     assert(internals->watches != NULL);
-    assert(internals->instance != -1);
 
     u64 base_size = sizeof(struct inotify_event);
     u64 max_size  = base_size + AL_MAX_PATH + 2;
     u8  buffer[max_size];
 
-    AL_AsyncWhile(&watcher->thread.mutex, SYNC_EXIT) {
-        ssize_t bytes_read = read(internals->instance, (void*)buffer, max_size);
-        if (bytes_read == -1) {
-            switch (errno) {
-            case EAGAIN: break;
-            default: break;
-            }
-
-            usleep(watcher->update_ms * 1E3);
-            continue;
-        }
-
+    // drained, so the reactor sleeps until the next event
+    ssize_t bytes_read;
+    while ((bytes_read = read(fd, (void*)buffer, max_size)) > 0) {
         for (u64 byte = 0; byte < bytes_read;) {
             struct inotify_event* event = (struct inotify_event*)(buffer + byte);
             byte += base_size + event->len;
@@ -269,20 +481,24 @@ u32 s_FileWatcherProc(void* argument) {
             }
 
             enum FileEvent mask = s_TranslateFileEventType(event->mask);
+            if (mask == FILE_INVALID) continue;
 
-            AL_ForEach(watcher->callbacks, i) {
-                AL_FileEventCallback* fwcb = watcher->callbacks + i;
-                if (mask & fwcb->event) {
-                    fwcb->callback(
-                        directory, AL_CopyC(event->name, event->len), fwcb->user_context
-                    );
-                }
+            // new subdirectories are watched right away
+            if (!(mask & FILE_DIRECTORY)) {
+                s_Coalesce(watcher, directory, event->name, mask);
+                continue;
             }
+
+            AL_String file = AL_CopyC(event->name, strlen(event->name));
+            s_Dispatch(watcher, directory, file, mask);
+            AL_Free(file);
         }
     }
 
-    AL_WakeCondition(&watcher->thread.mutex);
-    return true;
+    if (bytes_read == -1 && errno != EAGAIN) LWARN("Could not read filewatcher events.");
+
+    // pending events are handed out at the end of their window
+    s_ArmTimer(watcher);
 }
 
 #endif
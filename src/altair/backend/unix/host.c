@@ -0,0 +1,414 @@
+#include "../../aldefs.h"
+#if defined(AL_PLATFORM_UNIX)
+
+#    include <linux/futex.h>
+#    include <linux/memfd.h>
+#    include <malloc.h>
+#    include <pthread.h>
+#    include <signal.h>
+#    include <spawn.h>
+#    include <stdio.h>
+#    include <stdlib.h>
+#    include <string.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <sys/wait.h>
+#    include <time.h>
+
+#    include "../../atomic.h"
+#    include "../../host.h"
+#    include "../../log.h"
+#    include "../../manager.h"
+#    include "../../plugin.h"
+#    include "../../string.h"
+#    include "../../threads.h"
+
+// polls before sleeping on the futex; a round trip to a busy host stays in this window
+#    define UNIX_HOST_SPIN    4096
+#    define UNIX_HOST_EXIT_MS 1000
+
+#    define UNIX_HOST_MASK    (AL_HOST_RING_SIZE - 1)
+
+extern char** environ;
+
+typedef struct {
+    pid_t           pid;
+    AL_String       filepath;
+    pthread_mutex_t lock; // one call in flight, as the rings have one producer each
+} UnixHostInternal;
+
+static AL_Host* s_hosts[AL_HOST_MAX]; // atomic, which host each update entry point calls
+static b8       s_hosted = false;
+static u32      s_spin   = 0; // 0 on a single CPU, where spinning only delays the other side
+
+// shared memory futexes, so no FUTEX_PRIVATE_FLAG
+static void     s_Sleep(u32* word, u32 value, u32 timeout_ms) {
+    struct timespec timeout = { .tv_sec  = timeout_ms / 1000,
+                                .tv_nsec = (timeout_ms % 1000) * 1000000 };
+    syscall(
+        SYS_futex, word, FUTEX_WAIT, value, timeout_ms == AL_TIMEOUT_MAX ? NULL : &timeout, NULL, 0
+    );
+}
+
+static void s_Wake(u32* word) { syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0); }
+
+// every call waits for its reply, so a ring never holds more than one message
+static void s_Push(AL_HostRing* ring, AL_HostMessage message) {
+    u64 head                              = ring->head;
+    ring->messages[head & UNIX_HOST_MASK] = message;
+
+    AL_AtomicStore(&ring->head, head + 1, AL_SEQ_CST);
+    AL_AtomicAdd(&ring->signal, 1, AL_SEQ_CST);
+    if (AL_AtomicLoad(&ring->waiting, AL_SEQ_CST)) s_Wake(&ring->signal);
+}
+
+static b8 s_TryPop(AL_HostRing* ring, AL_HostMessage* message) {
+    u64 tail = ring->tail;
+    if (AL_AtomicLoad(&ring->head, AL_ACQUIRE) == tail) return false;
+
+    *message = ring->messages[tail & UNIX_HOST_MASK];
+    AL_AtomicStore(&ring->tail, tail + 1, AL_RELEASE);
+    return true;
+}
+
+// spins, then sleeps until a push or the timeout; false if nothing arrived
+static b8 s_Pop(AL_HostRing* ring, AL_HostMessage* message, u32 timeout_ms) {
+    for (u32 spin = 0; spin < s_spin; ++spin) {
+        if (s_TryPop(ring, message)) return true;
+    }
+
+    // a push after the signal is read changes it, so the sleep can't miss it
+    u32 signal = AL_AtomicLoad(&ring->signal, AL_SEQ_CST);
+    AL_AtomicStore(&ring->waiting, true, AL_SEQ_CST);
+
+    if (AL_AtomicLoad(&ring->head, AL_SEQ_CST) == ring->tail)
+        s_Sleep(&ring->signal, signal, timeout_ms);
+
+    AL_AtomicStore(&ring->waiting, false, AL_RELAXED);
+    return s_TryPop(ring, message);
+}
+
+static b8 s_Exited(AL_Host* host) {
+    UnixHostInternal* internals = host->internals;
+    int               status;
+
+    if (waitpid(internals->pid, &status, WNOHANG) != internals->pid) return false;
+    AL_AtomicStore(&host->alive, false, AL_RELEASE);
+
+    if (WIFSIGNALED(status))
+        LERROR(
+            "Host of isolated plugin '%s' died of signal %d; its calls are skipped.",
+            internals->filepath, WTERMSIG(status)
+        );
+    else
+        LNOTE("Host of plugin '%s' exited (%d).", internals->filepath, WEXITSTATUS(status));
+
+    return true;
+}
+
+// with the host's lock held; false if the call failed or the host is gone
+static b8 s_Exchange(AL_Host* host, AL_HostMessage call, AL_HostMessage* reply) {
+    if (!AL_AtomicLoad(&host->alive, AL_ACQUIRE)) return false;
+
+    s_Push(&host->channel->calls, call);
+
+    while (!s_Pop(&host->channel->replies, reply, AL_HOST_POLL_MS)) {
+        if (s_Exited(host)) return false;
+    }
+
+    return reply->status != 0;
+}
+
+static u64 s_Bound(u64 size) { return size < AL_HOST_PAYLOAD_MAX ? size : AL_HOST_PAYLOAD_MAX; }
+
+static b8 s_Call(AL_Host* host, enum HostOp op, u64 argument) {
+    UnixHostInternal* internals = host->internals;
+    AL_HostMessage    call      = { .op = op, .status = 0, .argument = argument, .capacity = 0 };
+    AL_HostMessage    reply;
+
+    pthread_mutex_lock(&internals->lock);
+    b8 called = s_Exchange(host, call, &reply);
+    pthread_mutex_unlock(&internals->lock);
+    return called;
+}
+
+// update tables hold bare function pointers, so each host gets its own entry point
+static void s_InitSpin(void) {
+    if (sysconf(_SC_NPROCESSORS_ONLN) > 1) s_spin = UNIX_HOST_SPIN;
+}
+
+static void s_Update(u32 entry, u64 frame) {
+    AL_Host* host = AL_AtomicLoad(&s_hosts[entry], AL_ACQUIRE);
+    if (host) s_Call(host, HOST_OP_UPDATE, frame);
+}
+
+#    define UNIX_HOST_ENTRY(group, n)                                                              \
+        static void s_Update##group##n(u64 frame) { s_Update(group * 8 + n, frame); }
+
+#    define UNIX_HOST_GROUP(group)                                                                 \
+        UNIX_HOST_ENTRY(group, 0)                                                                  \
+        UNIX_HOST_ENTRY(group, 1)                                                                  \
+        UNIX_HOST_ENTRY(group, 2)                                                                  \
+        UNIX_HOST_ENTRY(group, 3)                                                                  \
+        UNIX_HOST_ENTRY(group, 4)                                                                  \
+        UNIX_HOST_ENTRY(group, 5)                                                                  \
+        UNIX_HOST_ENTRY(group, 6)                                                                  \
+        UNIX_HOST_ENTRY(group, 7)
+
+#    define UNIX_HOST_ENTRIES(group)                                                               \
+        s_Update##group##0, s_Update##group##1, s_Update##group##2, s_Update##group##3,            \
+            s_Update##group##4, s_Update##group##5, s_Update##group##6, s_Update##group##7
+
+UNIX_HOST_GROUP(0)
+UNIX_HOST_GROUP(1)
+UNIX_HOST_GROUP(2)
+UNIX_HOST_GROUP(3)
+UNIX_HOST_GROUP(4)
+UNIX_HOST_GROUP(5)
+UNIX_HOST_GROUP(6)
+UNIX_HOST_GROUP(7)
+
+// 8 groups of 8, one per AL_HOST_MAX
+static const PFN_host_update_t s_entries[AL_HOST_MAX] = {
+    UNIX_HOST_ENTRIES(0), UNIX_HOST_ENTRIES(1), UNIX_HOST_ENTRIES(2), UNIX_HOST_ENTRIES(3),
+    UNIX_HOST_ENTRIES(4), UNIX_HOST_ENTRIES(5), UNIX_HOST_ENTRIES(6), UNIX_HOST_ENTRIES(7),
+};
+
+static b8 s_HostExecutable(char* path) {
+    const char* override = getenv("ALTAIR_HOST");
+    if (override) {
+        snprintf(path, AL_MAX_PATH + 1, "%s", override);
+        return true;
+    }
+
+    char    executable[AL_MAX_PATH + 1];
+    ssize_t length = readlink("/proc/self/exe", executable, AL_MAX_PATH);
+    if (length <= 0) return false;
+
+    executable[length] = '\0';
+    return snprintf(path, AL_MAX_PATH + 1, "%s/altair-host", AL_PARENT(executable)) <= AL_MAX_PATH;
+}
+
+b8 AL_CreateHost(const char* filepath, AL_Host** host) {
+    if (!filepath || !host) {
+        LERROR("Cannot create a plugin host with a null filepath or output pointer.");
+        return false;
+    }
+
+    AL_Host*          created   = calloc(1, sizeof(AL_Host));
+    UnixHostInternal* internals = calloc(1, sizeof(UnixHostInternal));
+    if (!created || !internals) {
+        LERROR("Could not allocate host of plugin '%s'.", filepath);
+        free(created);
+        free(internals);
+        return false;
+    }
+
+    s_InitSpin();
+    created->internals  = internals;
+    created->entry      = AL_HOST_MAX;
+    internals->filepath = AL_CopyC(filepath, strlen(filepath));
+    internals->lock     = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+
+    for (u32 i = 0; i < AL_HOST_MAX && created->entry == AL_HOST_MAX; ++i) {
+        AL_Host* expected = NULL;
+        if (AL_AtomicCompareExchange(&s_hosts[i], &expected, created, AL_ACQ_REL))
+            created->entry = i;
+    }
+
+    char executable[AL_MAX_PATH + 1];
+    int  channel = -1;
+
+    if (created->entry == AL_HOST_MAX) {
+        LERROR("All %u plugin hosts are in use; cannot isolate '%s'.", AL_HOST_MAX, filepath);
+    } else if (!s_HostExecutable(executable)) {
+        LERROR("Cannot locate the plugin host executable.");
+    } else {
+        channel = syscall(SYS_memfd_create, "altair-host", MFD_CLOEXEC);
+    }
+
+    if (channel != -1 && ftruncate(channel, sizeof(AL_HostChannel)) == 0) {
+        void* mapping = mmap(
+            NULL, sizeof(AL_HostChannel), PROT_READ | PROT_WRITE, MAP_SHARED, channel, 0
+        );
+        created->channel = mapping == MAP_FAILED ? NULL : mapping;
+    }
+
+    if (created->channel) {
+        char  descriptor[16];
+        char* argv[] = { executable, descriptor, internals->filepath, NULL };
+        snprintf(descriptor, sizeof(descriptor), "%d", channel);
+
+        // other children, other hosts included, never inherit the channel; only this
+        // host's copy of it loses close-on-exec, by being duplicated onto itself
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, channel, channel);
+
+        if (posix_spawn(&internals->pid, executable, &actions, NULL, argv, environ) == 0)
+            created->alive = true;
+        else
+            LERROR("Could not launch plugin host '%s'.", executable);
+
+        posix_spawn_file_actions_destroy(&actions);
+    }
+
+    if (channel != -1) close(channel);
+
+    if (!created->alive) {
+        LERROR("Could not isolate plugin '%s'.", filepath);
+        AL_DestroyHost(created);
+        return false;
+    }
+
+    LINFO("Plugin '%s' isolated in host process %d.", filepath, internals->pid);
+    *host = created;
+    return true;
+}
+
+void AL_DestroyHost(AL_Host* host) {
+    if (!host) return;
+    UnixHostInternal* internals = host->internals;
+
+    if (AL_AtomicLoad(&host->alive, AL_ACQUIRE)) {
+        AL_HostMessage call = { .op = HOST_OP_EXIT, .status = 0, .argument = 0, .capacity = 0 };
+        AL_HostMessage reply;
+        s_Push(&host->channel->calls, call);
+
+        for (u32 waited = 0; !s_Exited(host); waited += AL_HOST_POLL_MS) {
+            if (waited < UNIX_HOST_EXIT_MS) {
+                s_Pop(&host->channel->replies, &reply, AL_HOST_POLL_MS);
+                continue;
+            }
+
+            LWARN("Host of plugin '%s' did not exit; killing it.", internals->filepath);
+            kill(internals->pid, SIGKILL);
+            waitpid(internals->pid, NULL, 0);
+            break;
+        }
+    }
+
+    if (host->entry < AL_HOST_MAX) AL_AtomicStore(&s_hosts[host->entry], NULL, AL_RELEASE);
+    if (host->channel) munmap(host->channel, sizeof(AL_HostChannel));
+
+    AL_Free(internals->filepath);
+    pthread_mutex_destroy(&internals->lock);
+    free(internals);
+    free(host);
+}
+
+i64 AL_HostSend(AL_Host* host, const void* data, u64 size, void* reply, u64 capacity) {
+    UnixHostInternal* internals = host->internals;
+    if (size > AL_HOST_PAYLOAD_MAX) {
+        LERROR(
+            "Message of %llu bytes to isolated plugin '%s' is over %u.", size, internals->filepath,
+            AL_HOST_PAYLOAD_MAX
+        );
+        return -1;
+    }
+
+    AL_HostMessage call = { .op       = HOST_OP_MESSAGE,
+                            .status   = 0,
+                            .argument = size,
+                            .capacity = s_Bound(capacity) };
+    AL_HostMessage answer;
+    i64            replied = -1;
+
+    pthread_mutex_lock(&internals->lock);
+    if (size) memcpy(host->channel->call_payload, data, size);
+
+    if (s_Exchange(host, call, &answer)) {
+        replied = answer.argument < call.capacity ? answer.argument : call.capacity;
+        if (replied) memcpy(reply, host->channel->reply_payload, replied);
+    }
+
+    pthread_mutex_unlock(&internals->lock);
+    return replied;
+}
+
+b8 AL_HostInit(AL_PluginManager* manager, AL_Plugin* plugin) {
+    (void)manager; // the host passes its own, empty manager
+    return s_Call(plugin->host, HOST_OP_INIT, 0);
+}
+
+PFN_host_update_t AL_HostUpdate(const AL_Host* host) { return s_entries[host->entry]; }
+
+b8                AL_InHost(void) { return s_hosted; }
+
+int               AL_RunHost(int argc, char* argv[]) {
+    if (argc < 3) {
+        LERROR("Usage: %s <channel descriptor> <plugin>", argc ? argv[0] : "altair-host");
+        return 1;
+    }
+
+    s_InitSpin();
+    s_hosted                = true;
+    pid_t           parent  = getppid();
+    int             fd      = atoi(argv[1]);
+    AL_HostChannel* channel = mmap(
+        NULL, sizeof(AL_HostChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0
+    );
+    close(fd);
+
+    AL_Plugin plugin;
+    if (channel == MAP_FAILED || !AL_LoadPlugin(argv[2], &plugin)) {
+        LERROR("Host could not load plugin '%s'.", argv[2]);
+        return 1;
+    }
+
+    // optional; without it messages fail
+    PFN_plugin_message_t message = AL_Get(&plugin, "message", false);
+
+    // isolated plugins see a manager of their own, holding nothing
+    AL_PluginManager manager;
+    b8               created     = false;
+    b8               initialized = false;
+
+    for (;;) {
+        AL_HostMessage call;
+        if (!s_Pop(&channel->calls, &call, 1000)) {
+            if (getppid() != parent) break; // the runtime is gone
+            continue;
+        }
+
+        AL_HostMessage reply = { .op = call.op, .status = true, .argument = 0, .capacity = 0 };
+
+        switch (call.op) {
+        case HOST_OP_INIT:
+            created = created || AL_CreatePluginManager(&manager);
+            initialized  = created && (!plugin.init || plugin.init(&manager, &plugin));
+            reply.status = initialized;
+            break;
+
+        case HOST_OP_UPDATE:
+            if (plugin.opt.update) plugin.opt.update(call.argument);
+            break;
+
+        case HOST_OP_MESSAGE:
+            reply.status = message != NULL;
+            if (!message) break;
+
+            reply.argument = s_Bound(message(
+                channel->call_payload, s_Bound(call.argument), channel->reply_payload,
+                s_Bound(call.capacity)
+            ));
+            break;
+
+        case HOST_OP_EXIT:
+            if (!initialized) plugin.cleanup = NULL;
+            reply.status = AL_UnloadPlugin(&plugin);
+            if (created) AL_DestroyPluginManager(&manager);
+
+            s_Push(&channel->replies, reply);
+            return 0;
+
+        default: reply.status = false; break;
+        }
+
+        s_Push(&channel->replies, reply);
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,312 @@
+#include "../../aldefs.h"
+#if defined(AL_PLATFORM_UNIX)
+
+#    include <fcntl.h>
+#    include <stdio.h>
+#    include <stdlib.h>
+#    include <string.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+
+#    include "../../array.h"
+#    include "../../atomic.h"
+#    include "../../clock.h"
+#    include "../../hash.h"
+#    include "../../log.h"
+#    include "../../plugincache.h"
+#    include "../../string.h"
+
+static const AL_CacheRecord* s_Records(const u8* mapping) {
+    return (const AL_CacheRecord*)(mapping + sizeof(AL_CacheHeader));
+}
+
+static b8 s_IsUsable(const u8* mapping, u64 length) {
+    const AL_CacheHeader* header = (const AL_CacheHeader*)mapping;
+    if (length < sizeof(AL_CacheHeader)) return false;
+
+    if (header->magic != AL_PLUGIN_CACHE_MAGIC || header->abi != AL_PLUGIN_ABI ||
+        header->record_size != sizeof(AL_CacheRecord))
+        return false;
+
+    u64 capacity = header->capacity;
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return false;
+    return length == sizeof(AL_CacheHeader) + capacity * sizeof(AL_CacheRecord);
+}
+
+static const AL_CacheRecord* s_FindMapped(const AL_PluginCache* cache, u64 uuid) {
+    if (!cache->mapping) return NULL;
+
+    const AL_CacheHeader* header  = (const AL_CacheHeader*)cache->mapping;
+    const AL_CacheRecord* records = s_Records(cache->mapping);
+    u64                   mask    = header->capacity - 1;
+
+    for (u64 i = uuid & mask, probes = 0; probes < header->capacity; i = (i + 1) & mask) {
+        if (records[i].uuid == uuid) return records + i;
+        if (records[i].uuid == 0) return NULL;
+        ++probes;
+    }
+
+    return NULL;
+}
+
+// mutex held; records used since opening shadow the file's
+static b8 s_Find(const AL_PluginCache* cache, u64 uuid, AL_CacheRecord* record) {
+    u64 index;
+    if (AL_HashMapFind(&cache->index, uuid, &index)) {
+        *record = cache->used[index];
+        return true;
+    }
+
+    const AL_CacheRecord* mapped = s_FindMapped(cache, uuid);
+    if (mapped) *record = *mapped;
+    return mapped != NULL;
+}
+
+// mutex held; 'changed' if the record differs from the file's
+static void s_Use(AL_PluginCache* cache, const AL_CacheRecord* record, b8 changed) {
+    cache->changed = cache->changed || changed;
+
+    u64 index;
+    if (AL_HashMapFind(&cache->index, record->uuid, &index)) {
+        cache->used[index] = *record;
+        return;
+    }
+
+    AL_Append(cache->used, *record);
+    if (!AL_HashMapInsert(&cache->index, record->uuid, AL_Size(cache->used) - 1))
+        AL_Size(cache->used) -= 1;
+}
+
+static b8 s_HashContents(const char* filepath, u64* content) {
+    int file = open(filepath, O_RDONLY | O_CLOEXEC);
+    if (file == -1) return false;
+
+    struct stat info;
+    void*       mapping = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+        mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (mapping == MAP_FAILED) return false;
+
+    *content = FNV_1A_C(mapping, info.st_size);
+    munmap(mapping, info.st_size);
+    return true;
+}
+
+static b8 s_FillPlugin(const AL_CacheRecord* record, const char* filepath, AL_Plugin* plugin) {
+    if (record->dependency_count > AL_PLUGIN_CACHE_DEPENDENCIES || record->phase >= PHASE_COUNT)
+        return false;
+
+    memset(plugin, 0, sizeof(AL_Plugin));
+
+    plugin->handle.filepath               = AL_CopyC(filepath, strlen(filepath));
+    *AL_Metadata(plugin->handle.filepath) = record->uuid;
+
+    plugin->dependencies                  = AL_Array(u64, record->dependency_count);
+    for (u32 i = 0; i < record->dependency_count; ++i)
+        AL_Append(plugin->dependencies, record->dependencies[i]);
+
+    plugin->uuid        = record->uuid;
+    plugin->type        = record->type;
+    plugin->phase       = record->phase;
+    plugin->priority    = record->priority;
+    plugin->period      = record->period;
+    plugin->period_ms   = record->period_ms;
+    plugin->budget_us   = record->budget_us;
+    plugin->deadline_ms = record->deadline_ms;
+    plugin->entries     = record->entries;
+    return true;
+}
+
+// mutex held; the records used this session, in a freshly sized table. the file's others
+// belong to plugins that weren't registered, and a path that is gone is never looked up.
+static b8 s_WriteCache(AL_PluginCache* cache) {
+    u64            count  = AL_Size(cache->used);
+    AL_CacheHeader header = { .magic       = AL_PLUGIN_CACHE_MAGIC,
+                              .abi         = AL_PLUGIN_ABI,
+                              .record_size = sizeof(AL_CacheRecord),
+                              .capacity    = 16 };
+    while (header.capacity < 2 * count) header.capacity *= 2;
+
+    AL_CacheRecord* records = calloc(header.capacity, sizeof(AL_CacheRecord));
+    if (!records) return false;
+
+    u64 mask = header.capacity - 1;
+    AL_ForEach(cache->used, i) {
+        u64 slot = cache->used[i].uuid & mask;
+        while (records[slot].uuid != 0) slot = (slot + 1) & mask;
+        records[slot] = cache->used[i];
+    }
+
+    AL_String temporary = AL_Copy(cache->filepath);
+    temporary           = AL_ConcatC(temporary, ".XXXXXX", 8);
+
+    int       file      = mkstemp(temporary);
+    b8        written   = file != -1;
+    u64       size      = header.capacity * sizeof(AL_CacheRecord);
+
+    if (written) {
+        written = write(file, &header, sizeof(header)) == sizeof(header) &&
+                  write(file, records, size) == (ssize_t)size;
+        written = close(file) == 0 && written;
+        written = written && rename(temporary, cache->filepath) == 0;
+        if (!written) unlink(temporary);
+    }
+
+    free(records);
+    AL_Free(temporary);
+    return written;
+}
+
+b8 AL_OpenPluginCache(const char* filepath, AL_PluginCache* cache) {
+    if (!filepath || !cache) {
+        LERROR("Cannot open plugin cache with a null filepath or output pointer.");
+        return false;
+    }
+
+    cache->mutex    = AL_CreateMutex();
+    cache->filepath = AL_CopyC(filepath, strlen(filepath));
+    cache->mapping  = NULL;
+    cache->length   = 0;
+    cache->mapped   = 0;
+    cache->used     = AL_Array(AL_CacheRecord, 0);
+    cache->changed  = false;
+    cache->hits     = 0;
+    cache->misses   = 0;
+
+    if (!AL_CreateHashMap(0, &cache->index)) {
+        LERROR("Could not create index of plugin cache '%s'.", filepath);
+        AL_Free(cache->used);
+        AL_Free(cache->filepath);
+        AL_DestroyMutex(&cache->mutex);
+        cache->filepath = NULL;
+        return false;
+    }
+
+    int file = open(filepath, O_RDONLY | O_CLOEXEC);
+    if (file == -1) {
+        LNOTE("No plugin cache at '%s' yet.", filepath);
+        return true;
+    }
+
+    struct stat info;
+    void*       mapping = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+        mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (mapping == MAP_FAILED || !s_IsUsable(mapping, info.st_size)) {
+        LWARN("Plugin cache '%s' is unusable; starting over.", filepath);
+        if (mapping != MAP_FAILED) munmap(mapping, info.st_size);
+        return true;
+    }
+
+    cache->mapping = mapping;
+    cache->length  = info.st_size;
+
+    const AL_CacheRecord* records = s_Records(mapping);
+    for (u64 i = 0; i < ((const AL_CacheHeader*)mapping)->capacity; ++i)
+        cache->mapped += records[i].uuid != 0;
+
+    return true;
+}
+
+b8 AL_ClosePluginCache(AL_PluginCache* cache) {
+    if (!cache || !cache->filepath) return true;
+
+    // rewritten only if it would differ: a record changed, or one went unused and is pruned
+    b8 stale   = cache->changed || AL_Size(cache->used) != cache->mapped;
+    b8 written = !stale || s_WriteCache(cache);
+    if (!written) LERROR("Could not write plugin cache '%s'.", cache->filepath);
+
+    LINFO(
+        "Plugin cache '%s': %llu hits, %llu misses.", cache->filepath, cache->hits, cache->misses
+    );
+
+    if (cache->mapping) munmap((void*)cache->mapping, cache->length);
+    AL_Free(cache->used);
+    AL_DestroyHashMap(&cache->index);
+    AL_DestroyMutex(&cache->mutex);
+    AL_Free(cache->filepath);
+
+    cache->filepath = NULL;
+    cache->mapping  = NULL;
+    return written;
+}
+
+b8 AL_StatPlugin(const char* filepath, AL_CacheKey* key) {
+    struct stat info;
+    if (!filepath || !key || stat(filepath, &info) == -1) return false;
+
+    key->device   = info.st_dev;
+    key->inode    = info.st_ino;
+    key->size     = info.st_size;
+    key->mtime_ns = info.st_mtim.tv_sec * AL_NS_PER_S + info.st_mtim.tv_nsec;
+    return true;
+}
+
+b8 AL_LookupPluginCache(
+    AL_PluginCache* cache, const char* filepath, const AL_CacheKey* key, AL_Plugin* plugin
+) {
+    if (!cache || !cache->filepath || !filepath || !key || !plugin) return false;
+
+    u64            uuid = FNV_1A_C(filepath, strlen(filepath));
+    AL_CacheRecord record;
+    b8             found, current;
+    ALSAFE(&cache->mutex, {
+        found   = s_Find(cache, uuid, &record);
+        current = found && memcmp(&record.key, key, sizeof(AL_CacheKey)) == 0;
+        if (current) s_Use(cache, &record, false);
+    });
+
+    // touched, copied over or rebuilt byte for byte
+    if (found && !current) {
+        u64 content;
+        found = record.key.size == key->size && s_HashContents(filepath, &content) &&
+                content == record.content;
+
+        record.key = *key;
+        if (found) ALSAFE(&cache->mutex, s_Use(cache, &record, true););
+    }
+
+    if (!found || !s_FillPlugin(&record, filepath, plugin)) {
+        AL_AtomicAdd(&cache->misses, 1, AL_RELAXED);
+        return false;
+    }
+
+    AL_AtomicAdd(&cache->hits, 1, AL_RELAXED);
+    return true;
+}
+
+void AL_StorePluginCache(AL_PluginCache* cache, const AL_CacheKey* key, const AL_Plugin* plugin) {
+    if (!cache || !cache->filepath || !key || !plugin) return;
+
+    u64 count = AL_Size(plugin->dependencies);
+    if (count > AL_PLUGIN_CACHE_DEPENDENCIES) return;
+
+    AL_CacheRecord record = { .uuid             = plugin->uuid,
+                              .key              = *key,
+                              .type             = plugin->type,
+                              .phase            = plugin->phase,
+                              .priority         = plugin->priority,
+                              .period           = plugin->period,
+                              .period_ms        = plugin->period_ms,
+                              .budget_us        = plugin->budget_us,
+                              .deadline_ms      = plugin->deadline_ms,
+                              .entries          = plugin->entries,
+                              .dependency_count = count };
+    memcpy(record.dependencies, plugin->dependencies, count * sizeof(u64));
+
+    // the metadata was read from the file 'key' names only if it still does
+    const char* filepath = plugin->handle.filepath;
+    AL_CacheKey after;
+    if (!s_HashContents(filepath, &record.content) || !AL_StatPlugin(filepath, &after) ||
+        memcmp(&after, key, sizeof(AL_CacheKey)) != 0)
+        return;
+
+    ALSAFE(&cache->mutex, s_Use(cache, &record, true););
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "../../aldefs.h"
+#if defined(AL_PLATFORM_UNIX)
+
+#    include <assert.h>
+#    include <errno.h>
+#    include <malloc.h>
+#    include <pthread.h>
+#    include <sys/epoll.h>
+#    include <sys/eventfd.h>
+#    include <unistd.h>
+
+#    include "../../array.h"
+#    include "../../log.h"
+#    include "../../reactor.h"
+#    include "../../threads.h"
+#    include "../../trace.h"
+
+typedef struct {
+    i32                    fd;
+    u32                    events;
+    PFN_reactor_callback_t callback;
+    void*                  user_context;
+    b8                     removed; // guarded by the lock
+} UnixWatch;
+
+typedef struct {
+    i32             epoll;
+    i32             wake;    // eventfd, written once to stop the loop
+    pthread_mutex_t lock;    // guards everything below
+    pthread_cond_t  idle;    // broadcast after each callback
+    UnixWatch**     watches; // array
+    UnixWatch**     retired; // unwatched, freed once the batch that may still name them is done
+    UnixWatch*      running; // whose callback is in flight, if any
+} UnixReactorInternal;
+
+static u32 s_ToEpoll(u32 events) {
+    u32 mask = 0;
+
+    if (events & REACTOR_READ) mask |= EPOLLIN;
+    if (events & REACTOR_WRITE) mask |= EPOLLOUT;
+    if (events & REACTOR_CLOSED) mask |= EPOLLRDHUP;
+    if (events & REACTOR_ONCE) mask |= EPOLLONESHOT;
+
+    return mask;
+}
+
+static u32 s_FromEpoll(u32 mask) {
+    u32 events = 0;
+
+    if (mask & EPOLLIN) events |= REACTOR_READ;
+    if (mask & EPOLLOUT) events |= REACTOR_WRITE;
+    if (mask & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) events |= REACTOR_CLOSED;
+
+    return events;
+}
+
+static u32 s_ReactorProc(void* argument) {
+    AL_Reactor*          reactor   = argument;
+    UnixReactorInternal* internals = reactor->internals;
+
+    struct epoll_event   ready[AL_REACTOR_BATCH];
+    b8                   stopped = false;
+
+    while (!stopped) {
+        i32 count = epoll_wait(internals->epoll, ready, AL_REACTOR_BATCH, -1);
+        if (count == -1) {
+            if (errno == EINTR) continue;
+
+            LERROR("Reactor could not wait on its descriptors; stopping.");
+            break;
+        }
+
+        for (i32 i = 0; i < count; ++i) {
+            UnixWatch* watch = ready[i].data.ptr;
+            if (!watch) {
+                stopped = true;
+                continue;
+            }
+
+            // unwatched since epoll_wait returned
+            pthread_mutex_lock(&internals->lock);
+            if (watch->removed) {
+                pthread_mutex_unlock(&internals->lock);
+                continue;
+            }
+
+            internals->running = watch;
+            pthread_mutex_unlock(&internals->lock);
+
+            u64 begin          = AL_TraceBegin();
+            watch->callback(watch->fd, s_FromEpoll(ready[i].events), watch->user_context);
+            AL_TraceEnd("fd ready", watch->fd, begin);
+
+            pthread_mutex_lock(&internals->lock);
+            internals->running = NULL;
+            pthread_cond_broadcast(&internals->idle);
+            pthread_mutex_unlock(&internals->lock);
+        }
+
+        pthread_mutex_lock(&internals->lock);
+        AL_ForEach(internals->retired, i) free(internals->retired[i]);
+        AL_Size(internals->retired) = 0;
+        pthread_mutex_unlock(&internals->lock);
+    }
+
+    return true;
+}
+
+b8 AL_CreateReactor(AL_Reactor* reactor) {
+    if (!reactor) {
+        LERROR("Cannot create a null reactor.");
+        return false;
+    }
+
+    i32 epoll = epoll_create1(EPOLL_CLOEXEC);
+    i32 wake  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll == -1 || wake == -1) {
+        LERROR("Could not create the descriptors of a reactor.");
+        if (epoll != -1) close(epoll);
+        if (wake != -1) close(wake);
+        return false;
+    }
+
+    // never read, so once written it stays ready and the loop can't miss it
+    struct epoll_event stop = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epoll, EPOLL_CTL_ADD, wake, &stop);
+
+    reactor->internals             = malloc(sizeof(UnixReactorInternal));
+    UnixReactorInternal* internals = reactor->internals;
+
+    internals->epoll               = epoll;
+    internals->wake                = wake;
+    internals->lock                = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    internals->watches             = AL_Array(UnixWatch*, 0);
+    internals->retired             = AL_Array(UnixWatch*, 0);
+    internals->running             = NULL;
+    pthread_cond_init(&internals->idle, NULL);
+
+    if (!AL_CreateThread(s_ReactorProc, reactor, true, &reactor->thread)) {
+        LERROR("Could not create reactor thread.");
+        return false;
+    }
+
+    return true;
+}
+
+b8 AL_DestroyReactor(AL_Reactor* reactor) {
+    if (!reactor) return true;
+    assert(reactor->internals != NULL);
+
+    UnixReactorInternal* internals = reactor->internals;
+
+    u64                  one       = 1;
+    if (write(internals->wake, &one, sizeof(one)) != sizeof(one))
+        LWARN("Could not signal the reactor to stop.");
+
+    if (!AL_DestroyThread(&reactor->thread, AL_TIMEOUT_MAX)) {
+        LERROR("Could not destroy reactor thread.");
+        return false;
+    }
+
+    u64 left = AL_Size(internals->watches);
+    if (left) LWARN("Reactor destroyed with %llu descriptors still watched.", left);
+
+    AL_ForEach(internals->watches, i) free(internals->watches[i]);
+    AL_ForEach(internals->retired, i) free(internals->retired[i]);
+    AL_Free(internals->watches);
+    AL_Free(internals->retired);
+
+    close(internals->epoll);
+    close(internals->wake);
+    pthread_cond_destroy(&internals->idle);
+    pthread_mutex_destroy(&internals->lock);
+
+    free(reactor->internals);
+    return true;
+}
+
+b8 AL_WatchFd(
+    AL_Reactor* reactor, i32 fd, u32 events, PFN_reactor_callback_t callback, void* user_context
+) {
+    if (!reactor || !callback) {
+        LERROR("Cannot watch a descriptor without a reactor and a callback.");
+        return false;
+    }
+
+    UnixReactorInternal* internals = reactor->internals;
+    UnixWatch*           watch     = malloc(sizeof(UnixWatch));
+
+    *watch                         = (UnixWatch){ .fd           = fd,
+                                                  .events       = events,
+                                                  .callback     = callback,
+                                                  .user_context = user_context,
+                                                  .removed      = false };
+
+    // level triggered: a callback that leaves data unread is simply called again, unless once
+    struct epoll_event interest    = { .events = s_ToEpoll(events), .data.ptr = watch };
+
+    pthread_mutex_lock(&internals->lock);
+    b8 added = epoll_ctl(internals->epoll, EPOLL_CTL_ADD, fd, &interest) == 0;
+    if (added) AL_Append(internals->watches, watch);
+    pthread_mutex_unlock(&internals->lock);
+
+    if (!added) {
+        switch (errno) {
+        case EEXIST: LERROR("Descriptor %d is already watched by the reactor.", fd); break;
+        case EPERM: LERROR("Descriptor %d cannot be waited on, as regular files can't.", fd); break;
+        default: LERROR("Reactor could not watch descriptor %d.", fd); break;
+        }
+
+        free(watch);
+        return false;
+    }
+
+    return true;
+}
+
+b8 AL_UnwatchFd(AL_Reactor* reactor, i32 fd) {
+    if (!reactor) {
+        LERROR("Cannot unwatch a descriptor of a null reactor.");
+        return false;
+    }
+
+    UnixReactorInternal* internals = reactor->internals;
+    UnixWatch*           watch     = NULL;
+
+    // the loop can't wait for its own callback to return
+    b8                   inside    = pthread_equal(pthread_self(), AL_GetPid(&reactor->thread));
+
+    pthread_mutex_lock(&internals->lock);
+
+    AL_ForEach(internals->watches, i) {
+        if (internals->watches[i]->fd != fd) continue;
+
+        watch = internals->watches[i];
+        AL_Remove(internals->watches, i);
+        break;
+    }
+
+    if (watch) {
+        epoll_ctl(internals->epoll, EPOLL_CTL_DEL, fd, NULL);
+        watch->removed = true;
+        AL_Append(internals->retired, watch);
+
+        while (!inside && internals->running == watch)
+            pthread_cond_wait(&internals->idle, &internals->lock);
+    }
+
+    pthread_mutex_unlock(&internals->lock);
+
+    if (!watch) LWARN("Descriptor %d is not watched by the reactor.", fd);
+    return watch != NULL;
+}
+
+#endif
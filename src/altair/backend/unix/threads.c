@@ -3,17 +3,28 @@
 
 #    include <assert.h>
 #    include <errno.h>
+#    include <limits.h>
+#    include <linux/futex.h>
 #    include <malloc.h>
 #    include <pthread.h>
+#    include <sched.h>
 #    include <string.h>
+#    include <sys/syscall.h>
 #    include <time.h>
+#    include <unistd.h>
 
+#    include "../../atomic.h"
+#    include "../../clock.h"
+#    include "../../coroutine.h"
+#    include "../../epoch.h"
 #    include "../../log.h"
 #    include "../../threads.h"
+#    include "../../trace.h"
 
 typedef struct {
     pthread_mutex_t lock;
-    pthread_cond_t  cond;
+    u32             sequence; // atomic, futex word the condition sleeps on, bumped by each wake
+    u32             sleepers; // atomic
 } UnixMutexInternal;
 
 typedef struct {
@@ -21,14 +32,36 @@ typedef struct {
     PFN_thread_proc_t routine;
 } UnixThreadInternal;
 
+// process private futexes; false once 'timeout_ms' has passed, true on a wake, a spurious
+// one included, or if the word no longer holds 'value'. a coroutine suspends instead
+static b8 s_Sleep(u32* word, u32 value, u32 timeout_ms) {
+    if (AL_InCoroutine()) return AL_SuspendWhile(word, value, timeout_ms);
+
+    struct timespec timeout = { .tv_sec  = timeout_ms / 1000,
+                                .tv_nsec = (timeout_ms % 1000) * AL_NS_PER_MS };
+
+    long            slept   = syscall(
+        SYS_futex, word, FUTEX_WAIT_PRIVATE, value,
+        timeout_ms == AL_TIMEOUT_MAX ? NULL : &timeout, NULL, 0
+    );
+    return slept == 0 || errno != ETIMEDOUT;
+}
+
+// coroutines parked on the word are woken too, all of them, since they don't sleep in the kernel
+static void s_Wake(u32* word, u32 count) {
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+    AL_WakeParked(word);
+}
+
 AL_Mutex AL_CreateMutex(void) {
     void*              internals = malloc(sizeof(UnixMutexInternal));
     UnixMutexInternal* mutex     = internals;
 
     mutex->lock                  = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
-    mutex->cond                  = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    mutex->sequence              = 0;
+    mutex->sleepers              = 0;
 
-    return (AL_Mutex){ .internals = internals, .flag = SYNC_UNSET };
+    return (AL_Mutex){ .internals = internals, .flag = SYNC_UNSET, .waiters = 0, .heartbeat = 0 };
 }
 
 void AL_DestroyMutex(AL_Mutex* mutex) {
@@ -38,7 +71,6 @@ void AL_DestroyMutex(AL_Mutex* mutex) {
     UnixMutexInternal* internals = mutex->internals;
 
     pthread_mutex_destroy(&internals->lock);
-    pthread_cond_destroy(&internals->cond);
     free(mutex->internals);
 }
 
@@ -62,23 +94,60 @@ b8 AL_AwaitCondition(AL_Mutex* mutex, u32 timeout_ms) {
 
     assert(mutex->internals != NULL);
 
+    // a wake between the unlock and the sleep bumps the sequence, so the sleep returns at once
     UnixMutexInternal* internals = mutex->internals;
-    if (timeout_ms == AL_TIMEOUT_MAX) {
-        pthread_cond_wait(&internals->cond, &internals->lock);
-    }
+    u32                sequence  = AL_AtomicLoad(&internals->sequence, AL_SEQ_CST);
+
+    AL_AtomicAdd(&internals->sleepers, 1, AL_SEQ_CST);
+    pthread_mutex_unlock(&internals->lock);
+
+    b8 woken = s_Sleep(&internals->sequence, sequence, timeout_ms);
+
+    pthread_mutex_lock(&internals->lock);
+    AL_AtomicSub(&internals->sleepers, 1, AL_SEQ_CST);
+
+    if (!woken) LWARN("Condition await timed out.");
+    return woken;
+}
 
-    else {
-        u64             seconds     = timeout_ms / 1000;
-        u64             nanoseconds = (timeout_ms % 1000) * 1E6;
-        struct timespec timeout     = { .tv_sec = seconds, .tv_nsec = nanoseconds };
+void AL_WakeCondition(AL_Mutex* mutex) {
+    if (!mutex) return LERROR("Cannon wake a condition on null mutex.");
+    UnixMutexInternal* internals = mutex->internals;
 
-        if (pthread_cond_timedwait(&internals->cond, &internals->lock, &timeout) == ETIMEDOUT) {
-            LWARN("Condition await timed out.");
-            return false;
+    AL_AtomicAdd(&internals->sequence, 1, AL_SEQ_CST);
+    if (AL_AtomicLoad(&internals->sleepers, AL_SEQ_CST)) s_Wake(&internals->sequence, 1);
+}
+
+// the store and the load of 'waiters' are both sequentially consistent, as are a waiter's
+// increment and its futex check, so either the writer sees the waiter or the waiter the flag
+static void s_WakeFlag(AL_Mutex* mutex) {
+    if (AL_AtomicLoad(&mutex->waiters, AL_SEQ_CST)) s_Wake(&mutex->flag, INT_MAX);
+}
+
+// sleeps until the flag no longer holds 'from'; false once 'timeout_ms' has passed
+static b8 s_AwaitFlagChange(AL_Mutex* mutex, u32 from, u32 timeout_ms) {
+    u64 deadline = timeout_ms == AL_TIMEOUT_MAX ? 0 : AL_GetTime() + timeout_ms * AL_NS_PER_MS;
+    b8  changed  = true;
+    u32 flag;
+
+    AL_AtomicAdd(&mutex->waiters, 1, AL_SEQ_CST);
+
+    // a ping is not a change to a waiter; pings wake no one, so a sleeper never answers them
+    while (changed && ((flag = AL_AtomicLoad(&mutex->flag, AL_SEQ_CST)) == from ||
+                       (from == SYNC_UNSET && flag == SYNC_PING))) {
+        u64 now = AL_GetTime();
+        if (deadline && now >= deadline) {
+            changed = false;
+            break;
         }
+
+        u32 remaining_ms = deadline ? (deadline - now + AL_NS_PER_MS - 1) / AL_NS_PER_MS
+                                    : AL_TIMEOUT_MAX;
+        s_Sleep(&mutex->flag, flag, remaining_ms);
     }
 
-    return true;
+    AL_AtomicSub(&mutex->waiters, 1, AL_SEQ_CST);
+    return changed;
 }
 
 enum SyncFlag AL_ReadSyncFlag(AL_Mutex* mutex) {
@@ -87,25 +156,41 @@ enum SyncFlag AL_ReadSyncFlag(AL_Mutex* mutex) {
         return SYNC_UNSET;
     }
 
-    enum SyncFlag flag;
+    // nearly always unset; only a set flag is claimed with a read-modify-write
+    u32 flag = AL_AtomicLoad(&mutex->flag, AL_RELAXED);
+    if (flag == SYNC_UNSET) return SYNC_UNSET;
 
-    ALSAFE(mutex, {
-        flag        = mutex->flag;
-        mutex->flag = SYNC_UNSET;
-    });
+    flag = AL_AtomicExchange(&mutex->flag, SYNC_UNSET, AL_ACQUIRE);
 
-    return flag;
+    // the watchdog counts in milliseconds, and pings often enough to keep this fresh
+    AL_AtomicStore(&mutex->heartbeat, AL_GetCoarseTime(), AL_RELAXED);
+    return flag == SYNC_PING ? SYNC_UNSET : flag;
+}
+
+b8 AL_PingSyncFlag(AL_Mutex* mutex) {
+    if (!mutex) {
+        LERROR("Cannot ping the sync flag of a null mutex.");
+        return false;
+    }
+
+    u32 unset = SYNC_UNSET;
+    return AL_AtomicCompareExchange(&mutex->flag, &unset, SYNC_PING, AL_RELAXED);
 }
 
 void AL_WriteSyncFlag(AL_Mutex* mutex, enum SyncFlag flag) {
     if (!mutex) return LERROR("Cannot safely write sync flag to null mutex.");
-    ALSAFE(mutex, mutex->flag = flag;);
+
+    AL_AtomicStore(&mutex->flag, flag, AL_SEQ_CST);
+    s_WakeFlag(mutex);
 }
 
-void AL_WakeCondition(AL_Mutex* mutex) {
-    if (!mutex) return LERROR("Cannon wake a condition on null mutex.");
-    UnixMutexInternal* internals = mutex->internals;
-    pthread_cond_signal(&internals->cond);
+b8 AL_AwaitSyncFlag(AL_Mutex* mutex, u32 timeout_ms) {
+    if (!mutex) {
+        LERROR("Cannot await the sync flag of a null mutex.");
+        return false;
+    }
+
+    return s_AwaitFlagChange(mutex, SYNC_UNSET, timeout_ms);
 }
 
 static void* s_ThreadProcWrapper(void* argument) {
@@ -117,13 +202,9 @@ static void* s_ThreadProcWrapper(void* argument) {
     AL_Thread* thread = argument;
     assert(thread->internals != NULL);
     UnixThreadInternal* internals = thread->internals;
-    enum SyncFlag       flag;
 
-    ALSAFE(&thread->mutex, {
-        while (thread->mutex.flag == SYNC_UNSET) AL_AwaitCondition(&thread->mutex, AL_TIMEOUT_MAX);
-        flag               = thread->mutex.flag;
-        thread->mutex.flag = SYNC_UNSET;
-    });
+    AL_AwaitSyncFlag(&thread->mutex, AL_TIMEOUT_MAX);
+    enum SyncFlag flag = AL_AtomicExchange(&thread->mutex.flag, SYNC_UNSET, AL_ACQUIRE);
 
     switch (flag) {
     case SYNC_START:
@@ -137,7 +218,15 @@ static void* s_ThreadProcWrapper(void* argument) {
     default: LERROR("Unknown sync flag enum."); break;
     }
 
-    AL_WakeCondition(&thread->mutex);
+    AL_ReleaseTraceRing();
+    AL_ReleaseEpochReader();
+
+    // tells AL_DestroyThread the routine is done with the thread and its context; past the
+    // store both may be freed, so the wake goes out without looking at 'waiters' first
+    u32* word = &thread->mutex.flag;
+    AL_AtomicStore(word, SYNC_WAIT, AL_SEQ_CST);
+    s_Wake(word, INT_MAX);
+
     pthread_exit(NULL);
 }
 
@@ -168,10 +257,7 @@ b8 AL_CreateThread(
 
     pthread_detach(internals->pid);
 
-    if (launch_immediately) {
-        AL_WriteSyncFlag(&thread->mutex, SYNC_START);
-        AL_WakeCondition(&thread->mutex);
-    }
+    if (launch_immediately) AL_WriteSyncFlag(&thread->mutex, SYNC_START);
 
     return true;
 }
@@ -187,7 +273,6 @@ void AL_StartThread(AL_Thread* thread) {
     UnixThreadInternal* internals = thread->internals;
 
     AL_WriteSyncFlag(&thread->mutex, SYNC_START);
-    AL_WakeCondition(&thread->mutex);
 }
 
 b8 AL_DestroyThread(AL_Thread* thread, u32 timeout_ms) {
@@ -198,23 +283,22 @@ b8 AL_DestroyThread(AL_Thread* thread, u32 timeout_ms) {
     pthread_t           pid       = internals->pid;
 
     LINFO("Syncing 0x%X", pid);
-    AL_WriteSyncFlag(&thread->mutex, SYNC_EXIT);
-    AL_WakeCondition(&thread->mutex);
-
-    ALSAFE(&thread->mutex, {
-        /*while (thread->mutex.flag != SYNC_WAIT) {
-            if (!AL_AwaitCondition(&thread->mutex, timeout_ms)) {
-                LERROR("Thread 0x%X timed out; could not destroy.", pid);
-                return false;
-            }
-        }*/
-        if (!AL_AwaitCondition(&thread->mutex, timeout_ms)) {
-            LERROR("Thread 0x%X timed out; could not destroy.", pid);
-            return false;
-        } else {
-            LNOTE("Await complete");
-        }
-    });
+    b8 exited = true;
+
+    // the routine may have returned on its own already
+    u32 flag = AL_AtomicLoad(&thread->mutex.flag, AL_SEQ_CST);
+    while (flag != SYNC_WAIT &&
+           !AL_AtomicCompareExchange(&thread->mutex.flag, &flag, SYNC_EXIT, AL_SEQ_CST));
+
+    if (flag != SYNC_WAIT) s_WakeFlag(&thread->mutex);
+
+    while (exited && (flag = AL_AtomicLoad(&thread->mutex.flag, AL_SEQ_CST)) != SYNC_WAIT)
+        exited = s_AwaitFlagChange(&thread->mutex, flag, timeout_ms);
+
+    if (!exited) {
+        LERROR("Thread 0x%X did not exit within %ums; left running.", pid, timeout_ms);
+        return false;
+    }
 
     AL_DestroyMutex(&thread->mutex);
     free(thread->internals);
@@ -228,4 +312,15 @@ u64 AL_GetPid(const AL_Thread* thread) {
     return internals->pid;
 }
 
+void AL_Yield(void) {
+    if (AL_InCoroutine()) AL_SuspendUntil(0);
+    else
+        sched_yield();
+}
+
+u32  AL_GetCoreCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? cores : 1;
+}
+
 #endif
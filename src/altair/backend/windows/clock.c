@@ -0,0 +1,23 @@
+#include "../../aldefs.h"
+#if defined(AL_PLATFORM_WIN)
+
+#    include "../../clock.h"
+
+u64 AL_GetTime(void) {
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    u64 seconds = counter.QuadPart / frequency.QuadPart;
+    u64 rest    = counter.QuadPart % frequency.QuadPart;
+    return seconds * AL_NS_PER_S + rest * AL_NS_PER_S / frequency.QuadPart;
+}
+
+u64 AL_GetCoarseTime(void) { return AL_GetTime(); }
+
+void AL_SleepUntil(u64 deadline_ns) {
+    u64 now = AL_GetTime();
+    if (deadline_ns > now) Sleep((DWORD)((deadline_ns - now) / AL_NS_PER_MS));
+}
+
+#endif
@@ -9,6 +9,7 @@
 #    include "../../dll.h"
 #    include "../../hash.h"
 #    include "../../log.h"
+#    include "../../trace.h"
 
 b8 AL_LoadDLL(const char* filepath, AL_DLL* dll) {
     if (!filepath) {
@@ -21,7 +22,10 @@ b8 AL_LoadDLL(const char* filepath, AL_DLL* dll) {
         return false;
     }
 
+    u64       begin  = AL_TraceBegin();
     HINSTANCE handle = LoadLibraryA(filepath);
+    if (begin) AL_TraceEnd("load dll", FNV_1A_C(filepath, strlen(filepath)), begin);
+
     if (!handle) {
         LERROR("Null library handle; cannot load DLL '%s'.", filepath);
         return false;
@@ -33,6 +37,33 @@ b8 AL_LoadDLL(const char* filepath, AL_DLL* dll) {
     return true;
 }
 
+b8 AL_LoadDLLCopy(const char* filepath, PFN_dll_check_t check, void* user_context, AL_DLL* dll) {
+    if (!filepath) {
+        LERROR("Invalid library filepath; loading failed.");
+        return false;
+    }
+
+    char directory[AL_MAX_PATH + 1];
+    char copy_path[AL_MAX_PATH + 1];
+
+    if (!GetTempPathA(sizeof(directory), directory) ||
+        !GetTempFileNameA(directory, "al", 0, copy_path) ||
+        !CopyFileA(filepath, copy_path, FALSE)) {
+        LERROR("Cannot create a private copy of DLL '%s'.", filepath);
+        return false;
+    }
+
+    if (check && !check(copy_path, user_context)) {
+        DeleteFileA(copy_path);
+        return false;
+    }
+
+    if (!AL_LoadDLL(copy_path, dll)) return false;
+
+    dll->filepath = filepath;
+    return true;
+}
+
 b8 AL_UnloadDLL(AL_DLL* dll) {
     if (!dll) {
         LERROR("Cannot unload null DLL.");
@@ -75,7 +106,10 @@ AL_Symbol* AL_LoadSymbol(AL_DLL* dll, const char* symname, b8 required) {
         if (symbol->hash == hash) return symbol;
     }
 
-    void* addr = GetProcAddress((HMODULE)dll->handle, symname);
+    u64   begin = AL_TraceBegin();
+    void* addr  = GetProcAddress((HMODULE)dll->handle, symname);
+    if (begin) AL_TraceEnd("load symbol", FNV_1A_C(dll->filepath, strlen(dll->filepath)), begin);
+
     if (!addr) {
         if (required) LERROR("Symbol '%s' not found within library '%s'.", symname, dll->filepath);
         else
@@ -111,4 +145,18 @@ AL_Symbol* AL_FindSymbol(AL_DLL* dll, const char* symname) {
     return NULL;
 }
 
+// PE sections aren't read; every plugin is classified through its exports
+b8 AL_ReadSection(const char* filepath, const char* name, void* data, u64 size, u64* read) {
+    (void)data;
+    (void)size;
+
+    if (!filepath || !name || !read) {
+        LERROR("Cannot read a library section with a null filepath, name or output.");
+        return false;
+    }
+
+    *read = 0;
+    return true;
+}
+
 #endif
@@ -110,4 +110,6 @@ void AL_Lock(AL_Thread* thread) { AcquireSRWLockExclusive((PSRWLOCK)thread->lock
 
 void AL_Unlock(AL_Thread* thread) { ReleaseSRWLockExclusive((PSRWLOCK)thread->lock); }
 
+void AL_Yield(void) { SwitchToThread(); }
+
 #endif
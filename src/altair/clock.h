@@ -0,0 +1,19 @@
+#ifndef AL_CLOCK_H_
+#define AL_CLOCK_H_
+
+#include "aldefs.h"
+
+#define AL_NS_PER_US 1000ull
+#define AL_NS_PER_MS 1000000ull
+#define AL_NS_PER_S  1000000000ull
+
+// monotonic nanoseconds from an arbitrary origin
+ALAPI u64  AL_GetTime(void);
+
+// same origin as AL_GetTime, at most a few milliseconds behind it, and cheaper to read
+ALAPI u64  AL_GetCoarseTime(void);
+
+// returns immediately if the deadline has already passed; suspends a calling coroutine
+ALAPI void AL_SleepUntil(u64 deadline_ns);
+
+#endif
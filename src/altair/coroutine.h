@@ -0,0 +1,71 @@
+#ifndef AL_COROUTINE_H_
+#define AL_COROUTINE_H_
+
+#include "aldefs.h"
+#include "reactor.h"
+#include "threads.h"
+
+// usable stack per coroutine, below which sits an inaccessible guard page
+#define AL_COROUTINE_STACK_SIZE (256 * 1024)
+
+// stacks kept mapped for reuse once their coroutines are destroyed
+#define AL_COROUTINE_POOL_SIZE  64
+
+// longest a coroutine without an 'on_wake' hook, waiting on a word or a descriptor, goes
+// between checks
+#define AL_COROUTINE_POLL_MS    16
+
+// a 'wake_ns' asking to be resumed only once 'on_wake' is called
+#define AL_COROUTINE_PARKED     0xffffffffffffffffull
+
+// asks whoever resumes the coroutine to do so soon; called from whichever thread woke it
+typedef void (*PFN_coroutine_wake_t)(void* user_context);
+
+// a stackful coroutine running a thread proc. a blocking call inside it (AL_AwaitCondition,
+// AL_AwaitSyncFlag, AL_SleepUntil, AL_Yield, AL_WaitFd) suspends it instead, and hands control
+// back to whoever resumed it. it may be resumed on a different thread each time, so thread
+// locals, errno included, can change across a blocking call.
+typedef struct AL_Coroutine_ {
+    void*                internals; // implementation defined
+    void*                user_context;
+    u64                  wake_ns;  // when it asked to be resumed, as an AL_GetTime; 0 right away
+    b8                   finished; // its proc returned
+    b8                   stopping; // blocking calls return after one suspension, as if timed out
+
+    // set by its owner; with it, a wait on a word parks the coroutine until the word is woken
+    PFN_coroutine_wake_t on_wake;
+    AL_Reactor*          reactor; // with 'on_wake' too, AL_WaitFd parks until the fd is ready
+} AL_Coroutine;
+
+b8       AL_CreateCoroutine(PFN_thread_proc_t proc, void* user_context, AL_Coroutine* coroutine);
+
+// the stack goes back to the pool; whatever an unfinished proc still holds on it is lost
+void     AL_DestroyCoroutine(AL_Coroutine* coroutine);
+
+// runs it until it suspends or returns; false once it has returned
+b8       AL_ResumeCoroutine(AL_Coroutine* coroutine);
+
+// marks it stopping and resumes it until its proc returns; false if that takes longer than
+// 'timeout_ms'. one that was never resumed is finished without running.
+b8       AL_StopCoroutine(AL_Coroutine* coroutine, u32 timeout_ms);
+
+// suspends the running coroutine until 'wake_ns'; only valid inside one
+void     AL_SuspendUntil(u64 wake_ns);
+
+// the coroutine counterpart of a futex wait: suspends while 'word' holds 'value'; false once
+// 'timeout_ms' has passed. parked until AL_WakeParked on the word if the coroutine has an
+// 'on_wake' hook, else checked at growing intervals. only valid inside a coroutine.
+b8       AL_SuspendWhile(u32* word, u32 value, u32 timeout_ms);
+
+// the coroutine counterpart of a futex wake, calling 'on_wake' of every coroutine parked on
+// 'word'; its new value must be stored first
+void     AL_WakeParked(u32* word);
+
+ALAPI b8 AL_InCoroutine(void);
+
+// waits for poll(2) 'events' on 'fd', suspending the coroutine it is called from, if any;
+// returns the events that occurred, 0 on timeout and -1 on error. a coroutine with a reactor
+// is resumed by the reactor once the descriptor is ready; one without polls it.
+ALAPI i32 AL_WaitFd(i32 fd, i32 events, u32 timeout_ms);
+
+#endif
@@ -17,10 +17,24 @@ typedef struct AL_DLL_ {
 
 b8         AL_LoadDLL(const char* filepath, AL_DLL* dll);
 
+// vets the private copy at 'copy_path' before it is loaded; false rejects it
+typedef b8 (*PFN_dll_check_t)(const char* copy_path, void* user_context);
+
+// loads a private copy of the library, so it can live alongside an already loaded
+// instance of the same file; 'dll->filepath' still names the original. 'check', if set,
+// sees the copy that is loaded, so what it reads can't change under it.
+b8 AL_LoadDLLCopy(
+    const char* filepath, PFN_dll_check_t check, void* user_context, AL_DLL* dll
+);
+
 b8         AL_UnloadDLL(AL_DLL* dll);
 
 AL_Symbol* AL_LoadSymbol(AL_DLL* dll, const char* symname, b8 required);
 
 AL_Symbol* AL_FindSymbol(AL_DLL* dll, const char* name, b8 required);
 
+// copies up to 'size' bytes of a named section out of the library file, without loading it;
+// 'read' is 0 if there is no such section
+b8         AL_ReadSection(const char* filepath, const char* name, void* data, u64 size, u64* read);
+
 #endif
@@ -0,0 +1,175 @@
+#include "epoch.h"
+
+#include <assert.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "aldefs.h"
+#include "array.h"
+#include "atomic.h"
+#include "log.h"
+#include "threads.h"
+
+#define NO_SLOT UINT32_MAX
+
+typedef struct {
+    const AL_Epoch* epoch; // the one it is inside of, while depth > 0
+    u32             slot;  // claimed on first entry, kept until the thread exits
+    u32             depth;
+} EpochLocal;
+
+static AL_THREAD_LOCAL EpochLocal s_local = { .epoch = NULL, .slot = NO_SLOT, .depth = 0 };
+
+// slot ownership is process wide, so switching epochs never needs a second slot
+static u64                        s_claimed[AL_EPOCH_MAX_READERS];
+static u64                        s_exhausted = false;
+
+static b8                         s_ClaimReader(void) {
+    for (u32 i = 0; i < AL_EPOCH_MAX_READERS; ++i) {
+        u64 expected = false;
+        if (AL_AtomicCompareExchange(s_claimed + i, &expected, true, AL_ACQ_REL)) {
+            s_local.slot = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// smallest epoch any reader is currently inside of
+static u64 s_MinimumActive(AL_Epoch* epoch) {
+    AL_AtomicFence(AL_SEQ_CST);
+    u64 minimum = AL_AtomicLoad(&epoch->global, AL_SEQ_CST);
+
+    // a reader without a slot may have seen any epoch
+    if (AL_AtomicLoad(&epoch->overflow, AL_SEQ_CST)) return AL_EPOCH_IDLE;
+
+    for (u32 i = 0; i < AL_EPOCH_MAX_READERS; ++i) {
+        u64 observed = AL_AtomicLoad(&epoch->readers[i].epoch, AL_SEQ_CST);
+        if (observed != AL_EPOCH_IDLE && observed < minimum) minimum = observed;
+    }
+
+    return minimum;
+}
+
+b8 AL_CreateEpoch(AL_Epoch* epoch) {
+    if (!epoch) {
+        LERROR("Cannot create a null epoch.");
+        return false;
+    }
+
+    u64 bytes      = AL_EPOCH_MAX_READERS * sizeof(AL_EpochReader);
+    epoch->readers = memalign(AL_CACHE_LINE, bytes);
+    if (!epoch->readers) {
+        LERROR("Could not allocate %lluB for epoch readers.", bytes);
+        return false;
+    }
+
+    memset(epoch->readers, 0, bytes);
+    epoch->global   = AL_EPOCH_IDLE + 1;
+    epoch->retired  = AL_Array(AL_Retired, 8);
+    epoch->overflow = 0;
+    return true;
+}
+
+void AL_DestroyEpoch(AL_Epoch* epoch) {
+    if (!epoch) return;
+    assert(epoch->retired != NULL);
+
+    AL_ForEach(epoch->retired, i) epoch->retired[i].reclaim(epoch->retired[i].pointer);
+
+    AL_Free(epoch->retired);
+    free(epoch->readers);
+}
+
+void AL_EnterEpoch(AL_Epoch* epoch) {
+    assert(epoch != NULL);
+
+    if (s_local.depth > 0) {
+        assert("Thread is already reading another epoch" && s_local.epoch == epoch);
+        s_local.depth += 1;
+        return;
+    }
+
+    if (s_local.slot == NO_SLOT && !s_ClaimReader() &&
+        !AL_AtomicExchange(&s_exhausted, true, AL_RELAXED))
+        LWARN("Out of epoch reader slots (max %u); reclaim waits on slotless readers.",
+              AL_EPOCH_MAX_READERS);
+
+    s_local.epoch = epoch;
+    s_local.depth = 1;
+
+    // the store must be globally visible before the caller loads any protected pointer
+    if (s_local.slot == NO_SLOT) {
+        AL_AtomicAdd(&epoch->overflow, 1, AL_SEQ_CST);
+    } else {
+        u64 global = AL_AtomicLoad(&epoch->global, AL_ACQUIRE);
+        AL_AtomicStore(&epoch->readers[s_local.slot].epoch, global, AL_RELAXED);
+    }
+
+    AL_AtomicFence(AL_SEQ_CST);
+}
+
+void AL_ExitEpoch(AL_Epoch* epoch) {
+    assert(s_local.epoch == epoch && s_local.depth > 0);
+
+    if (--s_local.depth > 0) return;
+
+    if (s_local.slot == NO_SLOT) AL_AtomicSub(&epoch->overflow, 1, AL_RELEASE);
+    else
+        AL_AtomicStore(&epoch->readers[s_local.slot].epoch, AL_EPOCH_IDLE, AL_RELEASE);
+}
+
+b8 AL_InEpoch(const AL_Epoch* epoch) { return s_local.epoch == epoch && s_local.depth > 0; }
+
+void AL_ReleaseEpochReader(void) {
+    if (s_local.slot == NO_SLOT) return;
+    assert(s_local.depth == 0);
+
+    AL_AtomicStore(s_claimed + s_local.slot, false, AL_RELEASE);
+    s_local.slot = NO_SLOT;
+}
+
+void AL_Retire(AL_Epoch* epoch, void* pointer, PFN_epoch_reclaim_t reclaim) {
+    assert(epoch != NULL && reclaim != NULL);
+    if (!pointer) return;
+
+    // readers that entered before this advance may still hold the pointer
+    u64        retired_at = AL_AtomicAdd(&epoch->global, 1, AL_SEQ_CST);
+    AL_Retired retired    = { .pointer = pointer, .reclaim = reclaim, .epoch = retired_at };
+    AL_Append(epoch->retired, retired);
+
+    AL_Reclaim(epoch);
+}
+
+void AL_Reclaim(AL_Epoch* epoch) {
+    assert(epoch != NULL);
+    if (AL_Size(epoch->retired) == 0) return;
+
+    u64 safe = s_MinimumActive(epoch);
+
+    for (u64 i = 0; i < AL_Size(epoch->retired);) {
+        AL_Retired retired = epoch->retired[i];
+        if (retired.epoch > safe) {
+            ++i;
+            continue;
+        }
+
+        AL_SwapRemove(epoch->retired, i);
+        retired.reclaim(retired.pointer);
+    }
+}
+
+void AL_Synchronize(AL_Epoch* epoch) {
+    AL_AwaitReaders(epoch);
+    AL_Reclaim(epoch);
+}
+
+void AL_AwaitReaders(AL_Epoch* epoch) {
+    assert(epoch != NULL);
+    assert("Cannot synchronize from inside the epoch" && !AL_InEpoch(epoch));
+
+    u64 target = AL_AtomicAdd(&epoch->global, 1, AL_SEQ_CST);
+    while (s_MinimumActive(epoch) < target) AL_Yield();
+}
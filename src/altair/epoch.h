@@ -0,0 +1,62 @@
+#ifndef AL_EPOCH_H_
+#define AL_EPOCH_H_
+
+#include "aldefs.h"
+
+// reader slots are claimed per thread and shared by every epoch
+#define AL_EPOCH_MAX_READERS 128
+#define AL_EPOCH_IDLE        0
+
+typedef void (*PFN_epoch_reclaim_t)(void*);
+
+typedef struct AL_EpochReader_ {
+    u64 epoch; // epoch observed on entry, AL_EPOCH_IDLE outside a critical section
+    u8  padding[AL_CACHE_LINE - sizeof(u64)];
+} AL_EpochReader;
+
+typedef struct AL_Retired_ {
+    void*               pointer;
+    PFN_epoch_reclaim_t reclaim;
+    u64                 epoch;
+} AL_Retired;
+
+// epoch-based reclamation; readers never block, writers retire memory that
+// is reclaimed once every reader has left the epoch it was retired in.
+// writer-side calls (retire, reclaim, synchronize) must be serialized by the caller.
+typedef struct AL_Epoch_ {
+    u64             global;
+    AL_EpochReader* readers;  // one cache line per thread slot
+    AL_Retired*     retired;  // array
+    u64             overflow; // readers inside without a slot, which hold off all reclaim
+} AL_Epoch;
+
+b8   AL_CreateEpoch(AL_Epoch* epoch);
+
+// reclaims everything still retired; no reader may be inside
+void AL_DestroyEpoch(AL_Epoch* epoch);
+
+// nestable; a thread claims a reader slot on its first entry into any epoch. with every
+// slot taken it still enters, but nothing is reclaimed until it leaves.
+void AL_EnterEpoch(AL_Epoch* epoch);
+
+void AL_ExitEpoch(AL_Epoch* epoch);
+
+b8   AL_InEpoch(const AL_Epoch* epoch);
+
+// gives the calling thread's reader slot back; called by every thread the library starts
+// before it exits
+void AL_ReleaseEpochReader(void);
+
+void AL_Retire(AL_Epoch* epoch, void* pointer, PFN_epoch_reclaim_t reclaim);
+
+void AL_Reclaim(AL_Epoch* epoch);
+
+// waits until every reader active at call time has left, then reclaims;
+// must not be called from inside the epoch
+void AL_Synchronize(AL_Epoch* epoch);
+
+// the wait of AL_Synchronize without the reclaim; it touches no writer state, so it needs no
+// serialization and may run while other writers retire
+void AL_AwaitReaders(AL_Epoch* epoch);
+
+#endif
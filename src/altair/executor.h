@@ -0,0 +1,67 @@
+#ifndef AL_EXECUTOR_H_
+#define AL_EXECUTOR_H_
+
+#include "aldefs.h"
+#include "threads.h"
+
+// ranges a worker can hold before splitting stops and it runs them inline
+#define AL_EXECUTOR_DEQUE_SIZE 256
+
+// persistent work-stealing pool. each thread owns a deque of index ranges: it splits the
+// range it holds, keeps working on one half and pushes the other for idle threads to steal.
+typedef struct AL_Executor_ {
+    void* internals; // implementation defined
+    u32   workers;   // not counting the calling thread
+} AL_Executor;
+
+struct AL_Task_;
+
+// a 'due_ns' that runs the task again only once AL_WakeTask is called on it
+#define AL_TASK_PARKED 0xffffffffffffffffull
+
+// returns the task to run next: a continuation, the task itself to run again once its 'due_ns'
+// has passed, or null. one that is already due runs right away on the same worker, unless
+// other tasks are waiting for it.
+typedef struct AL_Task_* (*PFN_task_proc_t)(struct AL_Task_* task);
+
+// long-running work shares the workers with AL_ExecuteFor jobs, which take precedence between
+// tasks. zero-initialized before its first submission, and owned by whoever submits it; it
+// must outlive its last run.
+typedef struct AL_Task_ {
+    PFN_task_proc_t proc;
+    void*           user_context;
+    u64             due_ns;    // not run before this AL_GetTime; 0 runs it as soon as possible
+    void*           executor;  // the rest is the executor's
+    u64             order;     // first come first served among tasks due
+    u32             index;     // in the executor's queue
+    u32             state;     // guarded by the executor
+    b8              cancelled; // guarded by the executor
+    b8              woken;     // guarded by the executor, woken while running
+} AL_Task;
+
+// zero workers runs everything on the calling thread, and takes no tasks
+ALAPI b8   AL_CreateExecutor(u32 workers, AL_Executor* executor);
+
+// tasks still queued are dropped
+ALAPI void AL_DestroyExecutor(AL_Executor* executor);
+
+// runs 'proc' for every index in [0, count) on the pool, the caller included, and returns
+// once all of them have finished. calls from different threads are serialized.
+ALAPI void AL_ExecuteFor(
+    AL_Executor* executor, u64 count, PFN_parallel_proc_t proc, void* user_context
+);
+
+// queues the task for the first free worker once it is due; false if it is queued, parked or
+// running already, or the executor has no workers
+ALAPI b8   AL_Submit(AL_Executor* executor, AL_Task* task);
+
+// makes a submitted task due now: a queued or parked one runs as soon as a worker is free, and
+// one that is running runs again once it returns itself, whatever its 'due_ns'. false if it is
+// idle or cancelled. needs no lock of the task's owner.
+ALAPI b8   AL_WakeTask(AL_Task* task);
+
+// takes the task off its queue, or waits for its run in flight to return, and keeps it from
+// running again until it is submitted anew; false if the run outlasts 'timeout_ms'
+ALAPI b8   AL_CancelTask(AL_Task* task, u32 timeout_ms);
+
+#endif
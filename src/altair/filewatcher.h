@@ -2,6 +2,7 @@
 #define AL_FILEWATCHER_H_
 
 #include "aldefs.h"
+#include "reactor.h"
 #include "string.h"
 #include "threads.h"
 
@@ -10,9 +11,13 @@ enum FileEvent {
     FILE_DIRECTORY = 0x0001,
     FILE_ADDED     = 0x0010,
     FILE_REMOVED   = 0x0100,
-    FILE_MODIFIED  = 0x1000
+    FILE_MODIFIED  = 0x1000,
+    FILE_FLUSHED   = 0x10000 // after each run of merged events, with null paths
 };
 
+// how long a path must go without events before its merged event is handed out
+#define AL_FILEWATCH_QUIET_MS 100
+
 typedef void (*PFN_filewatch_callback_t)(AL_String, AL_String, void* user_context);
 
 typedef struct AL_FileEventCallback_ {
@@ -21,22 +26,47 @@ typedef struct AL_FileEventCallback_ {
     void*                    user_context;
 } AL_FileEventCallback;
 
+typedef struct AL_FileWatcherStats_ {
+    u64 events;    // raw events on files that passed the filter
+    u64 emitted;   // merged events handed to callbacks
+    u64 coalesced; // events merged into another, or dropped with a file that came and went
+    u64 unsettled; // times a file was still changing size when its window closed
+} AL_FileWatcherStats;
+
 typedef struct AL_FileWatcher_ {
-    AL_Thread             thread;
+    AL_Reactor*           reactor;   // reads and hands out events on its thread
+    AL_Mutex              mutex;     // guards adding and removing callbacks
     AL_FileEventCallback* callbacks;
-    u64                   update_ms;
     void*                 internals; // implementation defined
     const char*           filter;
     u8                    max_depth;
+    u64                   quiet_ms;  // atomic
+    u64                   events;    // atomic
+    u64                   emitted;   // atomic
+    u64                   coalesced; // atomic
+    u64                   unsettled; // atomic
 } AL_FileWatcher;
 
-ALAPI b8 AL_CreateFileWatcher(
-    const char* path, u8 max_depth, const char* filter, u64 update_ms, AL_FileWatcher* watcher
+// events are read as soon as they arrive, and callbacks run, on the reactor's thread; the
+// reactor must outlive the watcher
+ALAPI b8   AL_CreateFileWatcher(
+    const char* path, u8 max_depth, const char* filter, AL_Reactor* reactor,
+    AL_FileWatcher* watcher
 );
 
-ALAPI b8 AL_DestroyFileWatcher(AL_FileWatcher* watcher);
+ALAPI b8   AL_DestroyFileWatcher(AL_FileWatcher* watcher);
+
+// bursts of events on one file (a linker's or cp's create, writes and close) are merged until
+// the file has had no events for 'quiet_ms' and kept its size across that window, then handed
+// out as a single event: added if the burst began with the file being created, removed if it
+// ends with the file gone, modified otherwise. directory events are never held back. the
+// events whose windows close within a window of each other are handed out in one run,
+// followed by FILE_FLUSHED.
+ALAPI void AL_SetQuietWindow(AL_FileWatcher* watcher, u64 quiet_ms);
+
+ALAPI void AL_GetFileWatcherStats(const AL_FileWatcher* watcher, AL_FileWatcherStats* stats);
 
-ALAPI b8 AL_AddFileCallback(
+ALAPI b8   AL_AddFileCallback(
     AL_FileWatcher* watcher, PFN_filewatch_callback_t callback, enum FileEvent event,
     void* user_context
 );
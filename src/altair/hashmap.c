@@ -0,0 +1,162 @@
+#include "hashmap.h"
+
+#include <assert.h>
+#include <malloc.h>
+#include <string.h>
+
+#include "aldefs.h"
+#include "log.h"
+
+#define AL_HASHMAP_MIN_CAPACITY 16
+
+// keys are usually FNV hashes already, but mix anyway so poor keys don't cluster
+static inline u64 s_Mix(u64 key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccd;
+    key ^= key >> 33;
+    return key;
+}
+
+static u64 s_RoundUpPow2(u64 value) {
+    u64 result = AL_HASHMAP_MIN_CAPACITY;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+static u64 s_ProbeSlot(const AL_HashMap* map, u64 key) {
+    u64 mask = map->capacity - 1;
+    u64 slot = s_Mix(key) & mask;
+
+    while (map->entries[slot].key != AL_HASHMAP_EMPTY_KEY && map->entries[slot].key != key)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+static b8 s_Rehash(AL_HashMap* map, u64 new_capacity) {
+    AL_HashEntry* old_entries  = map->entries;
+    u64           old_capacity = map->capacity;
+
+    AL_HashEntry* entries      = calloc(new_capacity, sizeof(AL_HashEntry));
+    if (!entries) {
+        LERROR("Could not allocate %lluB for hashmap.", new_capacity * sizeof(AL_HashEntry));
+        return false;
+    }
+
+    map->entries  = entries;
+    map->capacity = new_capacity;
+
+    for (u64 i = 0; i < old_capacity; ++i) {
+        if (old_entries[i].key == AL_HASHMAP_EMPTY_KEY) continue;
+        map->entries[s_ProbeSlot(map, old_entries[i].key)] = old_entries[i];
+    }
+
+    free(old_entries);
+    return true;
+}
+
+b8 AL_CreateHashMap(u64 capacity, AL_HashMap* map) {
+    if (!map) {
+        LERROR("Cannot create a null hashmap.");
+        return false;
+    }
+
+    map->capacity = s_RoundUpPow2(capacity * 2);
+    map->count    = 0;
+    map->entries  = calloc(map->capacity, sizeof(AL_HashEntry));
+
+    if (!map->entries) {
+        LERROR("Could not allocate %lluB for hashmap.", map->capacity * sizeof(AL_HashEntry));
+        return false;
+    }
+
+    return true;
+}
+
+void AL_DestroyHashMap(AL_HashMap* map) {
+    if (!map) return;
+
+    free(map->entries);
+    map->entries  = NULL;
+    map->capacity = 0;
+    map->count    = 0;
+}
+
+b8 AL_CloneHashMap(const AL_HashMap* source, AL_HashMap* map) {
+    if (!source || !map) {
+        LERROR("Cannot clone a null hashmap.");
+        return false;
+    }
+
+    u64 bytes    = source->capacity * sizeof(AL_HashEntry);
+    map->entries = malloc(bytes);
+    if (!map->entries) {
+        LERROR("Could not allocate %lluB for hashmap.", bytes);
+        return false;
+    }
+
+    memcpy(map->entries, source->entries, bytes);
+    map->capacity = source->capacity;
+    map->count    = source->count;
+    return true;
+}
+
+b8 AL_HashMapInsert(AL_HashMap* map, u64 key, u64 value) {
+    if (!map) {
+        LERROR("Cannot insert into a null hashmap.");
+        return false;
+    }
+
+    if (key == AL_HASHMAP_EMPTY_KEY) {
+        LERROR("Cannot insert reserved empty key into hashmap.");
+        return false;
+    }
+
+    assert(map->entries != NULL);
+
+    if ((map->count + 1) * 2 > map->capacity) {
+        if (!s_Rehash(map, map->capacity * 2)) return false;
+    }
+
+    u64 slot = s_ProbeSlot(map, key);
+    if (map->entries[slot].key == AL_HASHMAP_EMPTY_KEY) map->count += 1;
+
+    map->entries[slot] = (AL_HashEntry){ .key = key, .value = value };
+    return true;
+}
+
+b8 AL_HashMapFind(const AL_HashMap* map, u64 key, u64* value) {
+    if (!map || key == AL_HASHMAP_EMPTY_KEY) return false;
+    assert(map->entries != NULL);
+
+    u64 slot = s_ProbeSlot(map, key);
+    if (map->entries[slot].key == AL_HASHMAP_EMPTY_KEY) return false;
+
+    if (value) *value = map->entries[slot].value;
+    return true;
+}
+
+// backward-shift deletion keeps probe chains intact without tombstones
+b8 AL_HashMapErase(AL_HashMap* map, u64 key) {
+    if (!map || key == AL_HASHMAP_EMPTY_KEY) return false;
+    assert(map->entries != NULL);
+
+    u64 mask = map->capacity - 1;
+    u64 hole = s_ProbeSlot(map, key);
+    if (map->entries[hole].key == AL_HASHMAP_EMPTY_KEY) return false;
+
+    for (u64 next = (hole + 1) & mask; map->entries[next].key != AL_HASHMAP_EMPTY_KEY;
+         next     = (next + 1) & mask) {
+        u64 home = s_Mix(map->entries[next].key) & mask;
+
+        // entry may move into the hole only if its home slot is not within (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            map->entries[hole] = map->entries[next];
+            hole               = next;
+        }
+    }
+
+    map->entries[hole].key = AL_HASHMAP_EMPTY_KEY;
+    map->count -= 1;
+    return true;
+}
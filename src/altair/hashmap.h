@@ -0,0 +1,33 @@
+#ifndef AL_HASHMAP_H_
+#define AL_HASHMAP_H_
+
+#include "aldefs.h"
+
+#define AL_HASHMAP_EMPTY_KEY 0
+
+typedef struct AL_HashEntry_ {
+    u64 key;
+    u64 value;
+} AL_HashEntry;
+
+// open-addressing (linear probing) map from non-zero u64 keys to u64 values
+typedef struct AL_HashMap_ {
+    AL_HashEntry* entries;
+    u64           capacity; // power of two
+    u64           count;
+} AL_HashMap;
+
+b8   AL_CreateHashMap(u64 capacity, AL_HashMap* map);
+
+void AL_DestroyHashMap(AL_HashMap* map);
+
+b8   AL_CloneHashMap(const AL_HashMap* source, AL_HashMap* map);
+
+// inserts or overwrites, grows the table past 50% load
+b8   AL_HashMapInsert(AL_HashMap* map, u64 key, u64 value);
+
+b8   AL_HashMapFind(const AL_HashMap* map, u64 key, u64* value);
+
+b8   AL_HashMapErase(AL_HashMap* map, u64 key);
+
+#endif
@@ -0,0 +1,57 @@
+#include "histogram.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "aldefs.h"
+#include "atomic.h"
+
+static inline u32 s_BucketOf(u64 value) {
+    if (value < AL_HISTOGRAM_SUBS) return value;
+
+    u32 msb = 63 - __builtin_clzll(value);
+    u32 sub = (value >> (msb - AL_HISTOGRAM_SUB_BITS)) & (AL_HISTOGRAM_SUBS - 1);
+    return ((msb - AL_HISTOGRAM_SUB_BITS + 1) << AL_HISTOGRAM_SUB_BITS) + sub;
+}
+
+static u64 s_UpperBound(u32 bucket) {
+    if (bucket < AL_HISTOGRAM_SUBS) return bucket;
+
+    u32 shift = (bucket >> AL_HISTOGRAM_SUB_BITS) - 1;
+    u64 sub   = AL_HISTOGRAM_SUBS + (bucket & (AL_HISTOGRAM_SUBS - 1));
+    return ((sub + 1) << shift) - 1;
+}
+
+void AL_ClearHistogram(AL_Histogram* histogram) {
+    assert(histogram != NULL);
+    memset(histogram->counts, 0, sizeof(histogram->counts));
+}
+
+void AL_RecordValue(AL_Histogram* histogram, u64 value) {
+    u64* count = histogram->counts + s_BucketOf(value);
+    AL_AtomicStore(count, *count + 1, AL_RELAXED);
+}
+
+u64 AL_HistogramCount(const AL_Histogram* histogram) {
+    u64 total = 0;
+    for (u32 i = 0; i < AL_HISTOGRAM_BUCKETS; ++i)
+        total += AL_AtomicLoad(histogram->counts + i, AL_RELAXED);
+
+    return total;
+}
+
+u64 AL_HistogramQuantile(const AL_Histogram* histogram, f64 quantile) {
+    u64 total = AL_HistogramCount(histogram);
+    if (total == 0) return 0;
+
+    u64 rank = (u64)(quantile * total);
+    if (rank >= total) rank = total - 1;
+
+    u64 seen = 0;
+    for (u32 i = 0; i < AL_HISTOGRAM_BUCKETS; ++i) {
+        seen += AL_AtomicLoad(histogram->counts + i, AL_RELAXED);
+        if (seen > rank) return s_UpperBound(i);
+    }
+
+    return s_UpperBound(AL_HISTOGRAM_BUCKETS - 1);
+}
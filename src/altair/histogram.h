@@ -0,0 +1,26 @@
+#ifndef AL_HISTOGRAM_H_
+#define AL_HISTOGRAM_H_
+
+#include "aldefs.h"
+
+// 2^AL_HISTOGRAM_SUB_BITS linear buckets per power of two; at most 25% relative error
+#define AL_HISTOGRAM_SUB_BITS 2
+#define AL_HISTOGRAM_SUBS     (1 << AL_HISTOGRAM_SUB_BITS)
+#define AL_HISTOGRAM_BUCKETS  ((64 - AL_HISTOGRAM_SUB_BITS + 1) * AL_HISTOGRAM_SUBS)
+
+// HDR-style log-linear histogram over the whole u64 range. recording is a couple of
+// instructions and allocation free; one thread records, any thread may read.
+typedef struct AL_Histogram_ {
+    u64 counts[AL_HISTOGRAM_BUCKETS];
+} AL_Histogram;
+
+void AL_ClearHistogram(AL_Histogram* histogram);
+
+void AL_RecordValue(AL_Histogram* histogram, u64 value);
+
+u64  AL_HistogramCount(const AL_Histogram* histogram);
+
+// upper bound of the bucket holding the given quantile, 0 if empty
+u64  AL_HistogramQuantile(const AL_Histogram* histogram, f64 quantile);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef AL_HOST_H_
+#define AL_HOST_H_
+
+#include "aldefs.h"
+
+// isolated plugins alive at once; each owns one of a fixed set of update entry points
+#define AL_HOST_MAX       64
+#define AL_HOST_RING_SIZE 16 // messages, power of two
+
+// how long a call waits before checking whether the host process is still alive
+#define AL_HOST_POLL_MS   10
+
+// bytes a message, or its reply, carries across the process boundary at most
+#define AL_HOST_PAYLOAD_MAX 4096
+
+// the only calls a host serves. data crosses the process boundary through messages alone: an
+// isolated plugin's init gets an empty manager of the host's own, so it cannot query or
+// resolve the runtime's plugins, and they reach it through AL_SendMessage.
+enum HostOp {
+    HOST_OP_INIT = 1,
+    HOST_OP_UPDATE,
+    HOST_OP_MESSAGE, // 'argument' bytes of the call payload to 'message'; replies likewise
+    HOST_OP_EXIT,    // runs cleanup if init succeeded, then the host exits
+};
+
+typedef struct AL_HostMessage_ {
+    u32 op;
+    u32 status; // replies: non-zero on success
+    u64 argument;
+    u64 capacity; // HOST_OP_MESSAGE calls: room for the reply, at most AL_HOST_PAYLOAD_MAX
+} AL_HostMessage;
+
+// single producer, single consumer ring in shared memory. 'signal' is the futex word the
+// consumer sleeps on once spinning found the ring empty.
+typedef struct AL_HostRing_ {
+    u64            head; // atomic, written by the producer
+    u8             padding[AL_CACHE_LINE - sizeof(u64)];
+    u64            tail; // atomic, written by the consumer
+    u32            signal;  // atomic, bumped on every push
+    u32            waiting; // atomic, the consumer is asleep or about to be
+    u8             padding_[AL_CACHE_LINE - sizeof(u64) - 2 * sizeof(u32)];
+    AL_HostMessage messages[AL_HOST_RING_SIZE];
+} AL_HostRing;
+
+// mapped by both processes, from a memfd. a call waits for its reply, so one payload each
+// way is enough.
+typedef struct AL_HostChannel_ {
+    AL_HostRing calls;   // runtime -> host
+    AL_HostRing replies; // host -> runtime
+    u8          call_payload[AL_HOST_PAYLOAD_MAX];
+    u8          reply_payload[AL_HOST_PAYLOAD_MAX];
+} AL_HostChannel;
+
+struct AL_PluginManager_;
+struct AL_Plugin_;
+
+typedef struct AL_Host_ {
+    AL_HostChannel* channel;
+    void*           internals; // implementation defined
+    u32             entry;     // index of its update entry point
+    b8              alive;     // atomic, cleared once the host process is gone
+} AL_Host;
+
+// launches 'filepath' in a child host process, the 'altair-host' executable next to the
+// running one unless $ALTAIR_HOST names another
+b8                  AL_CreateHost(const char* filepath, AL_Host** host);
+
+// asks the host to run the plugin's cleanup and exit; killed if it doesn't in time
+void                AL_DestroyHost(AL_Host* host);
+
+// 'init' of an isolated plugin; runs the real one in its host
+b8                  AL_HostInit(struct AL_PluginManager_* manager, struct AL_Plugin_* plugin);
+
+// 'update' of an isolated plugin: a call into its host that returns once the update has run
+typedef void (*PFN_host_update_t)(u64);
+PFN_host_update_t   AL_HostUpdate(const AL_Host* host);
+
+// AL_SendMessage to an isolated plugin: copies the message into the channel, and the reply
+// out of it once the host has run 'message'; -1 if it is too large or the call failed
+i64                 AL_HostSend(
+    AL_Host* host, const void* data, u64 size, void* reply, u64 capacity
+);
+
+// host process side: serves calls for the plugin at argv[2] over the memfd argv[1]
+ALAPI int           AL_RunHost(int argc, char* argv[]);
+
+// whether this process is a host, where plugins are never isolated any further
+b8                  AL_InHost(void);
+
+#endif
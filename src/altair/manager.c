@@ -1,74 +1,1729 @@
 #include "manager.h"
 
 #include <assert.h>
+#include <malloc.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "aldefs.h"
 #include "array.h"
+#include "atomic.h"
+#include "clock.h"
+#include "epoch.h"
+#include "executor.h"
 #include "hash.h"
+#include "hashmap.h"
+#include "histogram.h"
 #include "log.h"
 #include "plugin.h"
+#include "reactor.h"
+#include "string.h"
 #include "threads.h"
+#include "timingwheel.h"
+#include "trace.h"
+
+// slot map helpers, called with the manager mutex held
+
+static u32 s_AcquireSlot(AL_PluginManager* manager, AL_Plugin* plugin) {
+    u32 index = manager->free_slot;
+
+    if (index != AL_INVALID_SLOT) {
+        manager->free_slot = manager->slots[index].next_free;
+    } else {
+        AL_PluginSlot slot = { .plugin = NULL, .generation = 1, .next_free = AL_INVALID_SLOT };
+        index              = AL_Size(manager->slots);
+        AL_Append(manager->slots, slot);
+    }
+
+    manager->slots[index].plugin    = plugin;
+    manager->slots[index].next_free   = AL_INVALID_SLOT;
+    manager->slots[index].suspended   = false;
+    manager->slots[index].quarantined = false;
+    manager->slots[index].lazy        = false;
+    manager->slots[index].dormant     = false;
+    return index;
+}
+
+static void s_ReleaseSlot(AL_PluginManager* manager, u32 index) {
+    AL_PluginSlot* slot = manager->slots + index;
+
+    slot->plugin        = NULL;
+    slot->dormant       = false;
+    slot->next_free     = manager->free_slot;
+    manager->free_slot  = index;
+
+    // stales every outstanding handle, skipping the reserved null generation
+    if (++slot->generation == 0) slot->generation = 1;
+}
+
+static AL_PluginSlot* s_FindSlot(AL_PluginManager* manager, u64 uuid) {
+    u64 slot;
+    return AL_HashMapFind(&manager->index, uuid, &slot) ? manager->slots + slot : NULL;
+}
+
+// snapshot helpers, called with the manager mutex held
+
+static void s_FreeRegistry(void* pointer) {
+    AL_Registry* registry = pointer;
+
+    AL_Free(registry->slots);
+    AL_Free(registry->plugins);
+    for (u32 phase = 0; phase < PHASE_COUNT; ++phase) {
+        AL_Free(registry->updates[phase]);
+        AL_Free(registry->priorities[phase]);
+        AL_Free(registry->stats[phase]);
+        AL_Free(registry->parallel[phase]);
+        AL_Free(registry->parallel_stats[phase]);
+    }
+
+    AL_Free(registry->periodic);
+    AL_Free(registry->dormant);
+    AL_DestroyHashMap(&registry->index);
+    free(registry);
+}
+
+static void s_DestroyPlugin(void* pointer) {
+    AL_Plugin*      plugin = pointer;
+    AL_UpdateStats* stats  = plugin->stats;
+
+    // a thread that won't stop may still be using both
+    if (!AL_UnloadPlugin(plugin) && (plugin->type & PLUGIN_ASYNC)) return;
+
+    free(stats);
+    free(plugin);
+}
+
+// unloads a plugin whose init never ran
+static void s_DiscardPlugin(AL_Plugin* plugin) {
+    plugin->cleanup = NULL;
+    s_DestroyPlugin(plugin);
+}
+
+// dispatch order; the uuid breaks ties so it never depends on registration or reload order
+static int s_CompareDispatch(const void* lhs, const void* rhs) {
+    const AL_Plugin* a = *(AL_Plugin* const*)lhs;
+    const AL_Plugin* b = *(AL_Plugin* const*)rhs;
+
+    if (a->phase != b->phase) return a->phase < b->phase ? -1 : 1;
+    if (a->priority != b->priority) return a->priority < b->priority ? -1 : 1;
+    return (a->uuid > b->uuid) - (a->uuid < b->uuid);
+}
+
+static b8 s_PublishRegistry(AL_PluginManager* manager) {
+    AL_Registry* registry = calloc(1, sizeof(AL_Registry));
+    if (!registry) {
+        LERROR("Could not allocate registry snapshot.");
+        return false;
+    }
+
+    u64 capacity       = AL_Size(manager->slots);
+    registry->slots    = AL_CloneArray(manager->slots);
+    registry->plugins  = AL_Array(AL_Plugin*, capacity);
+    registry->periodic = AL_Array(AL_Plugin*, 0);
+    registry->dormant  = AL_Array(u64, 0);
+    registry->version  = manager->registry ? manager->registry->version + 1 : 1;
+
+    b8 allocated       = registry->slots && registry->plugins && registry->periodic &&
+                   registry->dormant && AL_CloneHashMap(&manager->index, &registry->index);
+
+    for (u32 phase = 0; phase < PHASE_COUNT; ++phase) {
+        registry->updates[phase]        = AL_Array(PFN_plugin_update_t, capacity);
+        registry->priorities[phase]     = AL_Array(i32, capacity);
+        registry->stats[phase]          = AL_Array(AL_UpdateStats*, capacity);
+        registry->parallel[phase]       = AL_Array(PFN_plugin_update_t, capacity);
+        registry->parallel_stats[phase] = AL_Array(AL_UpdateStats*, capacity);
+
+        if (!registry->updates[phase] || !registry->priorities[phase] || !registry->stats[phase] ||
+            !registry->parallel[phase] || !registry->parallel_stats[phase])
+            allocated = false;
+    }
+
+    if (!allocated) {
+        LERROR("Could not build registry snapshot.");
+        s_FreeRegistry(registry);
+        return false;
+    }
+
+    AL_ForEach(manager->slots, i) {
+        AL_PluginSlot* slot = manager->slots + i;
+        if (slot->plugin && !slot->suspended && !slot->quarantined)
+            AL_Append(registry->plugins, slot->plugin);
+
+        // every update is due on its first frame
+        if (slot->plugin && slot->dormant &&
+            ((slot->plugin->entries & ENTRY_UPDATE) || (slot->plugin->type & PLUGIN_ASYNC)))
+            AL_Append(registry->dormant, slot->plugin->uuid);
+    }
+
+    // the frame loop only ever needs the function pointers, already in order
+    AL_Plugin** order = AL_CloneArray(registry->plugins);
+    qsort(order, AL_Size(order), sizeof(AL_Plugin*), s_CompareDispatch);
+
+    AL_ForEach(order, i) {
+        AL_Plugin* plugin = order[i];
+        if ((plugin->type & PLUGIN_ASYNC) || !plugin->opt.update) continue;
+
+        if (plugin->period || plugin->period_ms) {
+            AL_Append(registry->periodic, plugin);
+        } else if (plugin->type & PLUGIN_PARALLEL) {
+            AL_Append(registry->parallel[plugin->phase], plugin->opt.update);
+            AL_Append(registry->parallel_stats[plugin->phase], plugin->stats);
+        } else {
+            AL_Append(registry->updates[plugin->phase], plugin->opt.update);
+            AL_Append(registry->priorities[plugin->phase], plugin->priority);
+            AL_Append(registry->stats[plugin->phase], plugin->stats);
+        }
+    }
+
+    AL_Free(order);
+
+    AL_Registry* previous = AL_AtomicExchange(&manager->registry, registry, AL_SEQ_CST);
+    if (previous) AL_Retire(&manager->epoch, previous, s_FreeRegistry);
+
+    return true;
+}
+
+// a stuck update keeps its reader in the epoch for as long as it is stuck
+static b8 s_IsStalled(AL_PluginManager* manager) {
+    return AL_AtomicLoad(&manager->stalled, AL_RELAXED) != 0;
+}
+
+// a reader may still be dispatching into the plugins; unload them, in order, once none can be.
+// called without the mutex, so frames and other writers carry on while it waits, and so the
+// coroutines stopped here can call back into the manager on their way out
+static void s_RetirePlugins(AL_PluginManager* manager, AL_Plugin** plugins, u64 count) {
+    for (u64 i = 0; i < count; ++i) AL_StopPlugin(plugins[i]);
+
+    if (AL_InEpoch(&manager->epoch) || s_IsStalled(manager)) {
+        ALSAFE(&manager->mutex, {
+            for (u64 i = 0; i < count; ++i)
+                AL_Retire(&manager->epoch, plugins[i], s_DestroyPlugin);
+        });
+        return;
+    }
+
+    AL_AwaitReaders(&manager->epoch);
+    for (u64 i = 0; i < count; ++i) s_DestroyPlugin(plugins[i]);
+}
+
+static b8 s_HandsOff(const AL_Plugin* previous, const AL_Plugin* replacement) {
+    return previous->save_state && replacement->restore_state;
+}
+
+// takes the outgoing instances that hand off state out of dispatch, so none can touch it mid
+// hand-off; false if none do. their slots stay suspended until swapped, which keeps other
+// writers off them while the mutex is released. 'slots', 'previous' and 'replacements' are
+// parallel. mutex held
+static b8 s_SuspendHandOffs(
+    AL_PluginManager* manager, const u64* slots, AL_Plugin* const* previous,
+    AL_Plugin* const* replacements, u64 count
+) {
+    const char* refusal = AL_InEpoch(&manager->epoch) ? "from inside a frame"
+                          : s_IsStalled(manager)        ? "during a stalled update"
+                                                        : NULL;
+    b8          handing = false;
+
+    for (u64 i = 0; i < count; ++i) {
+        if (!s_HandsOff(previous[i], replacements[i])) continue;
+
+        handing = true;
+        if (refusal)
+            LWARN("Cannot hand off state of '%s' %s.", previous[i]->handle.filepath, refusal);
+    }
+
+    if (!handing || refusal) return false;
+
+    for (u64 i = 0; i < count; ++i) {
+        if (s_HandsOff(previous[i], replacements[i])) manager->slots[slots[i]].suspended = true;
+    }
+
+    if (s_PublishRegistry(manager)) return true;
+
+    for (u64 i = 0; i < count; ++i) manager->slots[slots[i]].suspended = false;
+    return false;
+}
+
+// waits out the frames that may still be inside the suspended instances, then moves their
+// state over; called without the mutex, so frames and other writers carry on meanwhile
+static void s_HandOffStates(
+    AL_PluginManager* manager, AL_Plugin* const* previous, AL_Plugin* const* replacements,
+    u64 count
+) {
+    AL_AwaitReaders(&manager->epoch);
+
+    for (u64 i = 0; i < count; ++i) {
+        if (!s_HandsOff(previous[i], replacements[i])) continue;
+
+        void* state = NULL;
+        u64   size  = 0;
+
+        if (!previous[i]->save_state(&state, &size)) {
+            LWARN("Plugin '%s' could not save its state.", previous[i]->handle.filepath);
+            continue;
+        }
+
+        if (!replacements[i]->restore_state(state, size))
+            LWARN("Plugin '%s' rejected its saved state.", replacements[i]->handle.filepath);
+        else
+            LINFO(
+                "Plugin '%s' handed over %lluB of state.", replacements[i]->handle.filepath, size
+            );
+    }
+}
+
+// swaps the replacements into 'slots' with a single publish, or puts the instances in them
+// back; either way a hand-off suspension ends. 'outgoing' receives what the slots held.
+// mutex held
+static b8 s_ReplaceInSlots(
+    AL_PluginManager* manager, const u64* slots, AL_Plugin* const* replacements,
+    AL_Plugin** outgoing, u64 count
+) {
+    b8* quarantined = AL_Array(b8, count);
+    b8  suspended   = false;
+
+    for (u64 i = 0; i < count; ++i) {
+        // handles to the slots stay valid and resolve to the replacements
+        AL_PluginSlot* slot = manager->slots + slots[i];
+        outgoing[i]         = slot->plugin;
+        suspended           = suspended || slot->suspended;
+        AL_Append(quarantined, slot->quarantined);
+
+        slot->plugin        = replacements[i];
+        slot->quarantined   = false;
+        slot->suspended     = false;
+    }
+
+    b8 swapped = s_PublishRegistry(manager);
+    for (u64 i = 0; i < count && !swapped; ++i) {
+        manager->slots[slots[i]].plugin      = outgoing[i];
+        manager->slots[slots[i]].quarantined = quarantined[i];
+    }
+
+    // the suspended snapshot is still the published one
+    if (!swapped && suspended && !s_PublishRegistry(manager))
+        LERROR("Could not resume plugins after a failed swap.");
+
+    AL_Free(quarantined);
+    return swapped;
+}
+
+// whether a state hand-off is reading any of them; mutex held
+static b8 s_AnyHandingOff(AL_PluginManager* manager, AL_Plugin* const* plugins) {
+    AL_ForEach(plugins, i) {
+        AL_PluginSlot* slot = s_FindSlot(manager, plugins[i]->uuid);
+        if (slot && slot->suspended) return true;
+    }
+
+    return false;
+}
+
+// dependency graph helpers
+
+static b8 s_IsRegistered(AL_PluginManager* manager, u64 uuid) {
+    const AL_Registry* registry   = AL_AcquireRegistry(manager);
+    b8                 registered = AL_HashMapFind(&registry->index, uuid, NULL);
+    AL_ReleaseRegistry(manager);
+
+    return registered;
+}
+
+static b8 s_DependenciesMet(AL_PluginManager* manager, const u64* dependencies) {
+    AL_ForEach(dependencies, i) {
+        if (!s_IsRegistered(manager, dependencies[i])) return false;
+    }
+
+    return true;
+}
+
+static b8 s_DependsOnAny(const AL_Plugin* plugin, const AL_HashMap* uuids) {
+    AL_ForEach(plugin->dependencies, i) {
+        if (AL_HashMapFind(uuids, plugin->dependencies[i], NULL)) return true;
+    }
+
+    return false;
+}
+
+static int s_CompareSequence(const void* lhs, const void* rhs) {
+    u64 a = (*(AL_Plugin* const*)lhs)->sequence;
+    u64 b = (*(AL_Plugin* const*)rhs)->sequence;
+    return (a > b) - (a < b);
+}
+
+static void s_Reverse(AL_Plugin** plugins) {
+    for (u64 i = 0, j = AL_Size(plugins); i < j / 2; ++i) {
+        AL_Plugin* swap    = plugins[i];
+        plugins[i]         = plugins[j - i - 1];
+        plugins[j - i - 1] = swap;
+    }
+}
+
+// registered plugins depending on 'uuid', directly or not, in init order; mutex held
+static AL_Plugin** s_CollectDependents(AL_PluginManager* manager, u64 uuid) {
+    AL_Plugin** dependents = AL_Array(AL_Plugin*, 0);
+    AL_HashMap  affected;
+
+    if (!AL_CreateHashMap(AL_Size(manager->slots), &affected)) return dependents;
+    AL_HashMapInsert(&affected, uuid, 0);
+
+    for (b8 grew = true; grew;) {
+        grew = false;
+
+        AL_ForEach(manager->slots, i) {
+            AL_Plugin* plugin = manager->slots[i].plugin;
+            if (!plugin || AL_HashMapFind(&affected, plugin->uuid, NULL)) continue;
+            if (!s_DependsOnAny(plugin, &affected)) continue;
+
+            AL_HashMapInsert(&affected, plugin->uuid, 0);
+            AL_Append(dependents, plugin);
+            grew = true;
+        }
+    }
+
+    AL_DestroyHashMap(&affected);
+    qsort(dependents, AL_Size(dependents), sizeof(AL_Plugin*), s_CompareSequence);
+    return dependents;
+}
+
+static void s_FreePending(AL_PendingPlugin* pending) {
+    AL_Free(pending->filepath);
+    AL_Free(pending->dependencies);
+}
+
+// parks a plugin until its dependencies are registered; mutex held
+static void s_Defer(AL_PluginManager* manager, const AL_Plugin* plugin, b8 lazy) {
+    AL_ForEach(manager->pending, i) {
+        if (*AL_Metadata(manager->pending[i].filepath) == plugin->uuid) return;
+    }
+
+    const char*      filepath = plugin->handle.filepath;
+    AL_PendingPlugin pending  = { .filepath     = AL_CopyC(filepath, strlen(filepath)),
+                                  .dependencies = AL_CloneArray(plugin->dependencies),
+                                  .lazy         = lazy };
+
+    *AL_Metadata(pending.filepath) = plugin->uuid;
+    AL_Append(manager->pending, pending);
+}
+
+static b8 s_TakeReadyPending(AL_PluginManager* manager, AL_PendingPlugin* ready) {
+    b8 found = false;
+
+    ALSAFE(&manager->mutex, {
+        AL_ForEach(manager->pending, i) {
+            if (!s_DependenciesMet(manager, manager->pending[i].dependencies)) continue;
+
+            *ready = manager->pending[i];
+            AL_SwapRemove(manager->pending, i);
+            found = true;
+            break;
+        }
+    });
+
+    return found;
+}
+
+static void s_RegisterReadyPending(AL_PluginManager* manager) {
+    AL_PendingPlugin ready;
+
+    while (s_TakeReadyPending(manager, &ready)) {
+        LINFO("Dependencies of parked plugin '%s' are registered.", ready.filepath);
+        if (ready.lazy) AL_RegisterPluginLazy(manager, ready.filepath);
+        else
+            AL_RegisterPlugin(manager, ready.filepath);
+        s_FreePending(&ready);
+    }
+}
+
+// async plugins
+
+// one step of a plugin without a thread, stamped like an update so the watchdog sees it
+static AL_Task* s_StepProc(AL_Task* task) {
+    AL_Plugin*      plugin = task->user_context;
+    AL_UpdateStats* stats  = plugin->stats;
+
+    u64             start  = AL_GetTime();
+    AL_AtomicStore(&stats->running, start, AL_RELAXED);
+
+    u32 wait_ms = plugin->step(plugin);
+
+    u64 end     = AL_GetTime();
+    AL_AtomicStore(&stats->running, 0, AL_RELAXED);
+    if (AL_IsTracing()) AL_TraceSpan("step", plugin->uuid, start, end);
+
+    if (wait_ms == AL_STEP_DONE) return NULL;
+
+    task->due_ns = wait_ms == AL_STEP_PARK ? AL_TASK_PARKED : end + (u64)wait_ms * AL_NS_PER_MS;
+    return task;
+}
+
+// once the plugin is published; its thread, or its first step, may use the manager right away
+static void s_StartAsync(AL_PluginManager* manager, AL_Plugin* plugin) {
+    if (!plugin->step) {
+        AL_StartThread(&plugin->opt.thread);
+        return;
+    }
+
+    plugin->task.proc         = s_StepProc;
+    plugin->task.user_context = plugin;
+    plugin->task.due_ns       = 0;
+
+    // its descriptor waits park on the reactor instead of polling
+    if (plugin->type & PLUGIN_COROUTINE) plugin->coroutine.reactor = &manager->reactor;
+
+    if (!AL_Submit(&manager->executor, &plugin->task))
+        LERROR("Could not schedule asynchronous plugin '%s'.", plugin->handle.filepath);
+}
+
+// stall watchdog
+
+typedef struct {
+    AL_Plugin* plugin; // identity only, never dereferenced once the snapshot is released
+    u64        uuid;
+} Stall;
+
+// reports plugins past their deadline, once per stall, and returns the ones to quarantine
+static Stall* s_FindStalls(AL_PluginManager* manager, u64 update_ms, u64 heartbeat_ms) {
+    Stall*             stalls   = AL_Array(Stall, 0);
+    u64                running  = 0;
+    u64                now      = AL_GetTime();
+
+    const AL_Registry* registry = AL_AcquireRegistry(manager);
+
+    AL_ForEach(registry->plugins, i) {
+        AL_Plugin*      plugin = registry->plugins[i];
+        AL_UpdateStats* stats  = plugin->stats;
+        b8              async  = plugin->type & PLUGIN_ASYNC;
+
+        u64             limit  = async ? heartbeat_ms : update_ms;
+        if (!limit) continue;
+        if (plugin->deadline_ms) limit = plugin->deadline_ms;
+
+        // an async plugin's heartbeat is its thread answering a ping on the sync flag, or a step
+        // returning. a thread that answered the last ping is alive; one that has not stalled
+        // after its last answer, which is at most a watchdog period stale
+        b8        threaded = async && !plugin->step;
+        AL_Mutex* mutex    = &plugin->opt.thread.mutex;
+        if (threaded && AL_PingSyncFlag(mutex)) continue;
+
+        u64 since = threaded ? AL_AtomicLoad(&mutex->heartbeat, AL_RELAXED)
+                             : AL_AtomicLoad(&stats->running, AL_RELAXED);
+        if (!since || now < since + limit * AL_NS_PER_MS) continue;
+
+        if (!async) running += 1;
+        if (stats->flagged == since) continue;
+
+        stats->flagged = since;
+        AL_AtomicStore(&stats->stalls, stats->stalls + 1, AL_RELAXED);
+
+        LWARN(
+            "Plugin '%s' %s for %llums, past its %llums deadline; quarantined.",
+            plugin->handle.filepath,
+            threaded ? "has not checked in" : (async ? "has been stepping" : "has been updating"),
+            (now - since) / AL_NS_PER_MS, limit
+        );
+
+        Stall stall = { .plugin = plugin, .uuid = plugin->uuid };
+        AL_Append(stalls, stall);
+    }
+
+    AL_ReleaseRegistry(manager);
+
+    AL_AtomicStore(&manager->stalled, running, AL_RELAXED);
+    return stalls;
+}
+
+static void s_Quarantine(AL_PluginManager* manager, const Stall* stalls) {
+    ALSAFE(&manager->mutex, {
+        b8 changed = false;
+
+        AL_ForEach(stalls, i) {
+            u64 slot;
+            if (!AL_HashMapFind(&manager->index, stalls[i].uuid, &slot)) continue;
+
+            // reloaded or unregistered in the meantime
+            AL_PluginSlot* entry = manager->slots + slot;
+            if (entry->plugin != stalls[i].plugin || entry->quarantined) continue;
+
+            entry->quarantined = true;
+            changed            = true;
+        }
+
+        if (changed && !s_PublishRegistry(manager)) LERROR("Could not publish quarantine.");
+    });
+}
+
+// idle unloading, run by the watchdog too
+
+// the metadata of a loaded plugin, to stand in for it while it is dormant
+static AL_Plugin* s_CreateDormant(const AL_Plugin* loaded) {
+    AL_Plugin*      plugin = malloc(sizeof(AL_Plugin));
+    AL_UpdateStats* stats  = calloc(1, sizeof(AL_UpdateStats));
+
+    if (!plugin || !stats || !AL_CopyPluginMetadata(loaded, plugin)) {
+        free(plugin);
+        free(stats);
+        return NULL;
+    }
+
+    plugin->stats       = stats;
+    plugin->stats->uuid = plugin->uuid;
+    return plugin;
+}
+
+// woken lazy plugins nothing resolved for 'idle_ms'; ones with an update or a thread are
+// always in use
+static u64* s_FindIdle(AL_PluginManager* manager, u64 idle_ms) {
+    u64*               idle     = AL_Array(u64, 0);
+    u64                now      = AL_GetTime();
+
+    const AL_Registry* registry = AL_AcquireRegistry(manager);
+
+    AL_ForEach(registry->slots, i) {
+        const AL_PluginSlot* slot = registry->slots + i;
+        if (!slot->plugin || !slot->lazy || slot->dormant) continue;
+
+        const AL_Plugin* plugin = slot->plugin;
+        if ((plugin->entries & ENTRY_UPDATE) || (plugin->type & PLUGIN_ASYNC)) continue;
+
+        if (now >= AL_AtomicLoad(&plugin->used, AL_RELAXED) + idle_ms * AL_NS_PER_MS)
+            AL_Append(idle, plugin->uuid);
+    }
+
+    AL_ReleaseRegistry(manager);
+    return idle;
+}
+
+// mutex held
+static b8 s_HasLoadedDependents(AL_PluginManager* manager, u64 uuid) {
+    AL_Plugin** dependents = s_CollectDependents(manager, uuid);
+    b8          loaded     = false;
+
+    AL_ForEach(dependents, i) {
+        if (!s_FindSlot(manager, dependents[i]->uuid)->dormant) loaded = true;
+    }
+
+    AL_Free(dependents);
+    return loaded;
+}
+
+// swaps an idle plugin back for its metadata
+static void s_PutToSleep(AL_PluginManager* manager, u64 uuid, u64 idle_ns) {
+    AL_Plugin* asleep = NULL;
+
+    ALSAFE(&manager->mutex, {
+        AL_PluginSlot* slot   = s_FindSlot(manager, uuid);
+        AL_Plugin*     plugin = slot && !slot->dormant ? slot->plugin : NULL;
+
+        // resolved since it was found idle, or still needed
+        if (plugin && AL_GetTime() < AL_AtomicLoad(&plugin->used, AL_RELAXED) + idle_ns)
+            plugin = NULL;
+        if (plugin && s_HasLoadedDependents(manager, uuid)) plugin = NULL;
+        if (plugin && slot->suspended) plugin = NULL;
+
+        AL_Plugin* dormant = plugin ? s_CreateDormant(plugin) : NULL;
+        if (dormant) {
+            slot->plugin  = dormant;
+            slot->dormant = true;
+
+            if (s_PublishRegistry(manager)) {
+                LINFO("Idle plugin '%s' unloaded until its next use.", dormant->handle.filepath);
+                asleep = plugin;
+            } else {
+                slot->plugin  = plugin;
+                slot->dormant = false;
+                s_DestroyPlugin(dormant);
+            }
+        }
+    });
+
+    if (!asleep) return;
+
+    // stopped without the mutex, then retired deferred, so the watchdog never waits on a frame
+    AL_StopPlugin(asleep);
+    ALSAFE(&manager->mutex, AL_Retire(&manager->epoch, asleep, s_DestroyPlugin););
+}
+
+static u32 s_WatchdogProc(void* argument) {
+    AL_PluginManager* manager = argument;
+
+    AL_AsyncWhile(&manager->watchdog.mutex, SYNC_EXIT) {
+        u64    wake         = AL_GetTime() + AL_WATCHDOG_PERIOD_MS * AL_NS_PER_MS;
+        u32    update_ms    = AL_AtomicLoad(&manager->update_deadline_ms, AL_RELAXED);
+        u32    heartbeat_ms = AL_AtomicLoad(&manager->heartbeat_deadline_ms, AL_RELAXED);
+        u32    idle_ms      = AL_AtomicLoad(&manager->idle_ms, AL_RELAXED);
+
+        Stall* stalls       = s_FindStalls(manager, update_ms, heartbeat_ms);
+        if (AL_Size(stalls)) s_Quarantine(manager, stalls);
+        AL_Free(stalls);
+
+        if (idle_ms) {
+            u64* idle = s_FindIdle(manager, idle_ms);
+            AL_ForEach(idle, i) s_PutToSleep(manager, idle[i], idle_ms * AL_NS_PER_MS);
+            AL_Free(idle);
+        }
+
+        AL_SleepUntil(wake);
+    }
+
+    return 0;
+}
 
 b8 AL_CreatePluginManager(AL_PluginManager* manager) {
     LINFO("Initializing plugin manager.");
 
     if (!manager) {
-        LERROR("Cannot initialize null plugin manager.");
+        LERROR("Cannot initialize null plugin manager.");
+        return false;
+    }
+
+    manager->mutex     = AL_CreateMutex();
+    manager->slots     = AL_Array(AL_PluginSlot, 0);
+    manager->free_slot = AL_INVALID_SLOT;
+    manager->pending   = AL_Array(AL_PendingPlugin, 0);
+    manager->sequence  = 0;
+    manager->registry  = NULL;
+    manager->sampling  = false;
+    manager->budget_ns = 0;
+    manager->idle_ms   = 0;
+    manager->lazy      = false;
+
+    if (!AL_CreateHashMap(0, &manager->index) || !AL_CreateHashMap(0, &manager->waking) ||
+        !AL_CreateHashMap(0, &manager->registering)) {
+        LERROR("Could not create plugin registry index.");
+        return false;
+    }
+
+    if (!AL_CreateEpoch(&manager->epoch)) {
+        LERROR("Could not create plugin registry epoch.");
+        return false;
+    }
+
+    if (!s_PublishRegistry(manager)) {
+        LERROR("Could not publish initial plugin registry.");
+        return false;
+    }
+
+    AL_PeriodicState* periodic = &manager->periodic;
+    AL_CreateTimingWheel(0, &periodic->wheel);
+    periodic->due      = AL_Array(AL_PeriodicTimer*, 0);
+    periodic->version  = 0;
+    periodic->frame    = 0;
+    periodic->frame_ns = 0;
+    periodic->last_ns  = 0;
+    periodic->started  = false;
+
+    if (!AL_CreateHashMap(0, &periodic->timers)) {
+        LERROR("Could not create periodic plugin index.");
+        return false;
+    }
+
+    u32 cores = AL_GetCoreCount();
+    // at least one worker, which steps async plugins even on a single core
+    if (!AL_CreateExecutor(cores > 1 ? cores - 1 : 1, &manager->executor)) {
+        LERROR("Could not create plugin update executor.");
+        return false;
+    }
+
+    if (!AL_CreateReactor(&manager->reactor)) {
+        LERROR("Could not create plugin reactor.");
+        return false;
+    }
+
+    manager->update_deadline_ms    = 0;
+    manager->heartbeat_deadline_ms = 0;
+    manager->stalled               = 0;
+    manager->cache.filepath        = NULL; // until AL_OpenMetadataCache
+
+    if (!AL_CreateThread(s_WatchdogProc, manager, true, &manager->watchdog)) {
+        LERROR("Could not create plugin watchdog.");
+        return false;
+    }
+
+    LSUCCESS("Plugin manager initialized succesfully.");
+    return true;
+}
+
+b8 AL_DestroyPluginManager(AL_PluginManager* manager) {
+    if (!manager) return true;
+    assert(manager->slots != NULL);
+
+    if (!AL_DestroyThread(&manager->watchdog, AL_WATCHDOG_PERIOD_MS * 20))
+        LWARN("Plugin watchdog did not stop.");
+
+    AL_Plugin** plugins = AL_Array(AL_Plugin*, AL_Size(manager->slots));
+    AL_ForEach(manager->slots, i) {
+        if (manager->slots[i].plugin) AL_Append(plugins, manager->slots[i].plugin);
+    }
+
+    // newest first, so no plugin outlives a dependency
+    qsort(plugins, AL_Size(plugins), sizeof(AL_Plugin*), s_CompareSequence);
+    s_Reverse(plugins);
+
+    AL_ForEach(plugins, i) s_DestroyPlugin(plugins[i]);
+    AL_Free(plugins);
+
+    AL_ForEach(manager->pending, i) s_FreePending(manager->pending + i);
+    AL_Free(manager->pending);
+
+    AL_DestroyExecutor(&manager->executor);
+    if (!AL_DestroyReactor(&manager->reactor)) LWARN("Plugin reactor did not stop.");
+    AL_ClosePluginCache(&manager->cache);
+
+    for (u64 i = 0; i < manager->periodic.timers.capacity; ++i) {
+        AL_HashEntry* entry = manager->periodic.timers.entries + i;
+        if (entry->key != AL_HASHMAP_EMPTY_KEY) free((void*)entry->value);
+    }
+
+    AL_DestroyHashMap(&manager->periodic.timers);
+    AL_Free(manager->periodic.due);
+
+    s_FreeRegistry(manager->registry);
+    AL_DestroyEpoch(&manager->epoch);
+
+    AL_Free(manager->slots);
+    AL_DestroyHashMap(&manager->index);
+    AL_DestroyHashMap(&manager->waking);
+    AL_DestroyHashMap(&manager->registering);
+    AL_DestroyMutex(&manager->mutex);
+
+    LSUCCESS("Plugin manager destroyed succesfully.");
+    return true;
+}
+
+// loads through the metadata cache: a hit skips reading the plugin's descriptor or exports,
+// a miss records what loading read. a side by side load maps a copy made after the lookup
+// would have been, so it reads the copy's own metadata and only records it
+static b8 s_LoadCached(
+    AL_PluginManager* manager, const char* filepath, b8 side_by_side, AL_Plugin* plugin
+) {
+    AL_PluginCache* cache = &manager->cache;
+    AL_CacheKey     key;
+    AL_Plugin       inspected;
+    b8              keyed = cache->filepath && AL_StatPlugin(filepath, &key);
+
+    if (keyed && !side_by_side && AL_LookupPluginCache(cache, filepath, &key, &inspected)) {
+        b8 loaded = AL_LoadInspectedPlugin(&inspected, side_by_side, plugin);
+        AL_UnloadPlugin(&inspected);
+        return loaded;
+    }
+
+    b8 loaded = side_by_side ? AL_LoadPluginCopy(filepath, plugin)
+                             : AL_LoadPlugin(filepath, plugin);
+    if (loaded && keyed) AL_StorePluginCache(cache, &key, plugin);
+    return loaded;
+}
+
+// loads a plugin outside of the registry, without initializing it
+static AL_Plugin* s_LoadPlugin(AL_PluginManager* manager, const char* filepath, b8 side_by_side) {
+    // heap allocated so the pointer (and async thread context) survives registry growth
+    AL_Plugin* plugin = malloc(sizeof(AL_Plugin));
+    if (!plugin) {
+        LERROR("Could not allocate plugin '%s'.", filepath);
+        return NULL;
+    }
+
+    if (!s_LoadCached(manager, filepath, side_by_side, plugin)) {
+        LERROR("Could not load plugin '%s'.", filepath);
+        free(plugin);
+        return NULL;
+    }
+
+    // each instance keeps its own timings, so a reload starts from a clean slate
+    plugin->stats = calloc(1, sizeof(AL_UpdateStats));
+    if (!plugin->stats) {
+        LERROR("Could not allocate update stats of plugin '%s'.", filepath);
+        s_DiscardPlugin(plugin);
+        return NULL;
+    }
+
+    plugin->stats->budget_ns = (u64)plugin->budget_us * AL_NS_PER_US;
+    plugin->stats->uuid      = plugin->uuid;
+
+    // a lazy plugin's idle time runs from its load
+    plugin->used             = AL_GetTime();
+    return plugin;
+}
+
+// reads a lazily registered plugin's metadata, leaving it unloaded
+static AL_Plugin* s_LoadDormant(AL_PluginManager* manager, const char* filepath) {
+    AL_Plugin* plugin = malloc(sizeof(AL_Plugin));
+    if (!plugin) {
+        LERROR("Could not allocate plugin '%s'.", filepath);
+        return NULL;
+    }
+
+    // a hit doesn't even open the file
+    AL_PluginCache* cache = &manager->cache;
+    AL_CacheKey     key;
+    b8              keyed = cache->filepath && AL_StatPlugin(filepath, &key);
+    b8              read  = keyed && AL_LookupPluginCache(cache, filepath, &key, plugin);
+
+    if (!read) {
+        read = AL_InspectPlugin(filepath, plugin);
+        if (read && keyed) AL_StorePluginCache(cache, &key, plugin);
+    }
+
+    if (!read) {
+        LERROR("Could not read metadata of plugin '%s'.", filepath);
+        free(plugin);
+        return NULL;
+    }
+
+    plugin->stats = calloc(1, sizeof(AL_UpdateStats));
+    if (!plugin->stats) {
+        LERROR("Could not allocate update stats of plugin '%s'.", filepath);
+        s_DestroyPlugin(plugin);
+        return NULL;
+    }
+
+    plugin->stats->uuid = plugin->uuid;
+    return plugin;
+}
+
+// safe to call concurrently; init order is handed out as plugins come up
+static b8 s_InitPlugin(AL_PluginManager* manager, AL_Plugin* plugin) {
+    u64 begin = AL_TraceBegin();
+    b8  ready = !plugin->init || plugin->init(manager, plugin);
+    AL_TraceEnd("init", plugin->uuid, begin);
+
+    if (!ready) {
+        LERROR("Initialization of plugin '%s' failed.", plugin->handle.filepath);
+        return false;
+    }
+
+    plugin->sequence = AL_AtomicAdd(&manager->sequence, 1, AL_RELAXED);
+    return true;
+}
+
+static AL_Plugin* s_CreatePlugin(AL_PluginManager* manager, const char* filepath, b8 side_by_side) {
+    AL_Plugin* plugin = s_LoadPlugin(manager, filepath, side_by_side);
+    if (!plugin) return NULL;
+
+    if (!s_InitPlugin(manager, plugin)) {
+        s_DiscardPlugin(plugin);
+        return NULL;
+    }
+
+    return plugin;
+}
+
+// called with the manager mutex held; the caller publishes
+static b8 s_IndexPlugin(AL_PluginManager* manager, AL_Plugin* plugin) {
+    if (AL_HashMapFind(&manager->index, plugin->uuid, NULL)) return false;
+
+    u32 slot = s_AcquireSlot(manager, plugin);
+    if (AL_HashMapInsert(&manager->index, plugin->uuid, slot)) return true;
+
+    s_ReleaseSlot(manager, slot);
+    return false;
+}
+
+static void s_UnindexPlugin(AL_PluginManager* manager, AL_Plugin* plugin) {
+    u64 slot;
+    if (!AL_HashMapFind(&manager->index, plugin->uuid, &slot)) return;
+
+    AL_HashMapErase(&manager->index, plugin->uuid);
+    s_ReleaseSlot(manager, slot);
+}
+
+// reserves the uuid of a path for one registration, so a racing one of the same path neither
+// loads it again, which dlopen would answer with the same instance, nor touches that instance;
+// mutex held
+static b8 s_ClaimRegistration(AL_PluginManager* manager, u64 uuid) {
+    if (AL_HashMapFind(&manager->index, uuid, NULL)) return false;
+    if (AL_HashMapFind(&manager->registering, uuid, NULL)) return false;
+    return AL_HashMapInsert(&manager->registering, uuid, 0);
+}
+
+static b8 s_ClaimPath(AL_PluginManager* manager, const char* filepath) {
+    u64 uuid = FNV_1A_C(filepath, strlen(filepath));
+    b8  claimed;
+
+    ALSAFE(&manager->mutex, claimed = s_ClaimRegistration(manager, uuid););
+    return claimed;
+}
+
+static void s_ReleasePath(AL_PluginManager* manager, const char* filepath) {
+    u64 uuid = FNV_1A_C(filepath, strlen(filepath));
+    ALSAFE(&manager->mutex, AL_HashMapErase(&manager->registering, uuid););
+}
+
+// called with the manager mutex held
+static b8 s_InsertPlugin(AL_PluginManager* manager, AL_Plugin* plugin) {
+    if (!s_IndexPlugin(manager, plugin)) return false;
+    if (s_PublishRegistry(manager)) return true;
+
+    s_UnindexPlugin(manager, plugin);
+    return false;
+}
+
+// lazy loading
+
+enum WakeClaim {
+    WAKE_AWAKE = 0, // not dormant (any more), or unregistered
+    WAKE_CLAIMED,
+    WAKE_BUSY, // another thread is waking it
+};
+
+static AL_THREAD_LOCAL u32 s_waking = 0; // wakes in progress on this thread
+
+// mutex held
+static enum WakeClaim      s_ClaimWake(
+    AL_PluginManager* manager, u64 uuid, AL_String* filepath, u64** dependencies
+) {
+    AL_PluginSlot* slot = s_FindSlot(manager, uuid);
+    if (!slot || !slot->dormant) return WAKE_AWAKE;
+    if (AL_HashMapFind(&manager->waking, uuid, NULL)) return WAKE_BUSY;
+    if (!AL_HashMapInsert(&manager->waking, uuid, 0)) return WAKE_AWAKE;
+
+    const char* path = slot->plugin->handle.filepath;
+    *filepath        = AL_CopyC(path, strlen(path));
+    *dependencies    = AL_CloneArray(slot->plugin->dependencies);
+    return WAKE_CLAIMED;
+}
+
+// loads and initializes a dormant plugin in place of its metadata, dependencies first; one
+// that fails to is unregistered
+static b8 s_WakePlugin(AL_PluginManager* manager, u64 uuid) {
+    AL_String      filepath     = NULL;
+    u64*           dependencies = NULL;
+    enum WakeClaim claim;
+
+    for (;;) {
+        ALSAFE(&manager->mutex, claim = s_ClaimWake(manager, uuid, &filepath, &dependencies););
+        if (claim != WAKE_BUSY) break;
+
+        // the thread waking it may be waiting on the one this thread is waking
+        if (s_waking) {
+            LERROR("Plugin 0x%llX is used while it is being loaded; cyclic init?", uuid);
+            return false;
+        }
+
+        AL_Yield();
+    }
+
+    if (claim == WAKE_AWAKE) return true;
+
+    s_waking += 1;
+    AL_ForEach(dependencies, i) s_WakePlugin(manager, dependencies[i]);
+    AL_Plugin* plugin = s_CreatePlugin(manager, filepath, false);
+    s_waking -= 1;
+
+    b8 woken          = false;
+    ALSAFE(&manager->mutex, {
+        AL_HashMapErase(&manager->waking, uuid);
+        AL_PluginSlot* slot = s_FindSlot(manager, uuid);
+
+        if (plugin && slot && slot->dormant) {
+            AL_Plugin* dormant = slot->plugin;
+            slot->plugin       = plugin;
+            slot->dormant      = false;
+
+            // the metadata has nothing to wait for
+            woken              = s_PublishRegistry(manager);
+            if (woken) {
+                AL_Retire(&manager->epoch, dormant, s_DestroyPlugin);
+            } else {
+                slot->plugin  = dormant;
+                slot->dormant = true;
+            }
+        }
+    });
+
+    if (woken) {
+        LSUCCESS("Plugin '%s' loaded on first use.", filepath);
+        if (plugin->type & PLUGIN_ASYNC) s_StartAsync(manager, plugin);
+    } else if (plugin) {
+        // unregistered in the meantime
+        s_DestroyPlugin(plugin);
+    } else {
+        LERROR("Plugin '%s' could not be loaded on first use; unregistering.", filepath);
+        AL_UnregisterPlugin(manager, filepath);
+    }
+
+    AL_Free(filepath);
+    AL_Free(dependencies);
+    return woken;
+}
+
+// a dormant plugin only needs its metadata read again; false if it isn't dormant
+static b8 s_RefreshDormant(AL_PluginManager* manager, const char* filepath) {
+    u64 uuid = FNV_1A_C(filepath, strlen(filepath));
+    b8  dormant;
+
+    ALSAFE(&manager->mutex, {
+        AL_PluginSlot* slot = s_FindSlot(manager, uuid);
+        dormant             = slot && slot->dormant;
+    });
+
+    if (!dormant) return false;
+
+    AL_Plugin* refreshed = s_LoadDormant(manager, filepath);
+    if (!refreshed) {
+        LERROR("Reload of dormant plugin '%s' failed; keeping its metadata.", filepath);
+        return true;
+    }
+
+    b8 swapped = false;
+    ALSAFE(&manager->mutex, {
+        AL_PluginSlot* slot = s_FindSlot(manager, uuid);
+        dormant             = slot && slot->dormant;
+
+        if (dormant) {
+            AL_Plugin* previous = slot->plugin;
+            slot->plugin        = refreshed;
+
+            swapped             = s_PublishRegistry(manager);
+            if (swapped) AL_Retire(&manager->epoch, previous, s_DestroyPlugin);
+            else
+                slot->plugin = previous;
+        }
+    });
+
+    if (!swapped) s_DestroyPlugin(refreshed);
+    if (swapped) LSUCCESS("Metadata of dormant plugin '%s' reloaded.", filepath);
+    return dormant;
+}
+
+typedef struct {
+    AL_PluginManager*  manager;
+    const char* const* filepaths;
+    AL_Plugin**        plugins;
+    b8*                skipped;
+    b8                 side_by_side; // next to running instances of the same paths
+} PluginBatch;
+
+static void s_LoadPluginProc(u64 index, void* argument) {
+    PluginBatch* batch = argument;
+    if (batch->skipped[index]) return;
+
+    batch->plugins[index] = s_LoadPlugin(
+        batch->manager, batch->filepaths[index], batch->side_by_side
+    );
+}
+
+static void s_InitPluginProc(u64 index, void* argument) {
+    PluginBatch* batch  = argument;
+    AL_Plugin*   plugin = batch->plugins[index];
+
+    if (!s_InitPlugin(batch->manager, plugin)) {
+        s_DiscardPlugin(plugin);
+        batch->plugins[index] = NULL;
+    }
+}
+
+// loads, initializes and indexes a plugin whose path the caller has claimed
+static AL_Plugin* s_RegisterClaimed(AL_PluginManager* manager, const char* filepath) {
+    AL_Plugin* plugin = s_LoadPlugin(manager, filepath, false);
+    if (!plugin) return NULL;
+
+    if (!s_DependenciesMet(manager, plugin->dependencies)) {
+        LNOTE("Plugin '%s' parked until its dependencies are registered.", filepath);
+        ALSAFE(&manager->mutex, s_Defer(manager, plugin, false););
+        s_DiscardPlugin(plugin);
+        return NULL;
+    }
+
+    if (!s_InitPlugin(manager, plugin)) {
+        s_DiscardPlugin(plugin);
+        return NULL;
+    }
+
+    b8 indexed;
+    ALSAFE(&manager->mutex, indexed = s_InsertPlugin(manager, plugin););
+
+    if (!indexed) {
+        LERROR("Plugin '%s' could not be indexed.", plugin->handle.filepath);
+        s_DestroyPlugin(plugin);
+        return NULL;
+    }
+
+    return plugin;
+}
+
+b8 AL_RegisterPlugin(AL_PluginManager* manager, const char* filepath) {
+    if (!filepath) {
+        LERROR("Cannot register plugin with null filepath.");
+        return false;
+    }
+
+    if (!manager) {
+        LERROR("Cannot register plugin '%s' with null plugin manager.", filepath);
+        return false;
+    }
+
+    // dlopen would hand back the running instance
+    if (!s_ClaimPath(manager, filepath)) {
+        LERROR("Plugin '%s' is already registered.", filepath);
+        return false;
+    }
+
+    AL_Plugin* plugin = s_RegisterClaimed(manager, filepath);
+    s_ReleasePath(manager, filepath);
+    if (!plugin) return false;
+
+    LSUCCESS("Plugin '%s' succesfully registered.", plugin->handle.filepath);
+
+    if (plugin->type & PLUGIN_ASYNC) s_StartAsync(manager, plugin);
+
+    s_RegisterReadyPending(manager);
+    return true;
+}
+
+b8 AL_RegisterPluginLazy(AL_PluginManager* manager, const char* filepath) {
+    if (!filepath) {
+        LERROR("Cannot register plugin with null filepath.");
+        return false;
+    }
+
+    if (!manager) {
+        LERROR("Cannot register plugin '%s' with null plugin manager.", filepath);
+        return false;
+    }
+
+    if (!s_ClaimPath(manager, filepath)) {
+        LERROR("Plugin '%s' is already registered.", filepath);
+        return false;
+    }
+
+    AL_Plugin* plugin = s_LoadDormant(manager, filepath);
+    if (!plugin) {
+        s_ReleasePath(manager, filepath);
+        return false;
+    }
+
+    if (!s_DependenciesMet(manager, plugin->dependencies)) {
+        LNOTE("Plugin '%s' parked until its dependencies are registered.", filepath);
+        ALSAFE(&manager->mutex, s_Defer(manager, plugin, true););
+        s_DestroyPlugin(plugin);
+        s_ReleasePath(manager, filepath);
+        return false;
+    }
+
+    b8 indexed;
+    ALSAFE(&manager->mutex, {
+        indexed = s_IndexPlugin(manager, plugin);
+        if (indexed) {
+            AL_PluginSlot* slot = s_FindSlot(manager, plugin->uuid);
+            slot->lazy          = true;
+            slot->dormant       = true;
+
+            if (!s_PublishRegistry(manager)) {
+                s_UnindexPlugin(manager, plugin);
+                indexed = false;
+            }
+        }
+
+        AL_HashMapErase(&manager->registering, plugin->uuid);
+    });
+
+    if (!indexed) {
+        LERROR("Plugin '%s' could not be indexed.", filepath);
+        s_DestroyPlugin(plugin);
+        return false;
+    }
+
+    LSUCCESS("Plugin '%s' registered; it loads on first use.", filepath);
+
+    s_RegisterReadyPending(manager);
+    return true;
+}
+
+// initializes one wave in parallel and commits it with a single publish; returns how many made it
+static u64 s_CommitWave(AL_PluginManager* manager, AL_Plugin** wave, u64 count) {
+    PluginBatch batch = { .manager = manager, .plugins = wave };
+    AL_ExecuteFor(&manager->executor, count, s_InitPluginProc, &batch);
+
+    u64 committed = 0;
+    ALSAFE(&manager->mutex, {
+        for (u64 i = 0; i < count; ++i) {
+            if (!wave[i]) continue;
+
+            if (s_IndexPlugin(manager, wave[i])) {
+                committed += 1;
+                continue;
+            }
+
+            LERROR("Plugin '%s' could not be indexed.", wave[i]->handle.filepath);
+            s_DestroyPlugin(wave[i]);
+            wave[i] = NULL;
+        }
+
+        if (committed && !s_PublishRegistry(manager)) {
+            for (u64 i = 0; i < count; ++i) {
+                if (!wave[i]) continue;
+
+                s_UnindexPlugin(manager, wave[i]);
+                s_DestroyPlugin(wave[i]);
+                wave[i] = NULL;
+            }
+
+            committed = 0;
+        }
+    });
+
+    for (u64 i = 0; i < count; ++i) {
+        if (wave[i] && (wave[i]->type & PLUGIN_ASYNC)) s_StartAsync(manager, wave[i]);
+    }
+
+    return committed;
+}
+
+u64 AL_RegisterPlugins(AL_PluginManager* manager, const char* const* filepaths, u64 count) {
+    if (!manager) {
+        LERROR("Cannot register plugins with null plugin manager.");
+        return 0;
+    }
+
+    if (!filepaths || count == 0) return 0;
+
+    AL_Plugin** plugins = calloc(count, sizeof(AL_Plugin*));
+    AL_Plugin** wave    = calloc(count, sizeof(AL_Plugin*));
+    b8*         skipped = calloc(count, sizeof(b8));
+
+    if (!plugins || !wave || !skipped) {
+        LERROR("Could not allocate batch of %llu plugins.", count);
+        free(plugins);
+        free(wave);
+        free(skipped);
+        return 0;
+    }
+
+    // dlopen hands out one shared instance per path, so each path may only be loaded once;
+    // the claim also turns away a path listed twice
+    for (u64 i = 0; i < count; ++i) {
+        skipped[i] = !s_ClaimPath(manager, filepaths[i]);
+        if (skipped[i]) LWARN("Plugin '%s' is already registered; skipped.", filepaths[i]);
+    }
+
+    // loading and symbol resolution fan out over the whole batch
+    PluginBatch batch = { .manager   = manager,
+                          .filepaths = filepaths,
+                          .plugins   = plugins,
+                          .skipped   = skipped };
+    AL_ExecuteFor(&manager->executor, count, s_LoadPluginProc, &batch);
+
+    // each wave is every plugin whose dependencies earlier waves (or the registry) provide,
+    // published before the next so their init can query it
+    u64 registered    = 0;
+    for (;;) {
+        u64 wave_size = 0;
+
+        for (u64 i = 0; i < count; ++i) {
+            if (!plugins[i] || !s_DependenciesMet(manager, plugins[i]->dependencies)) continue;
+
+            wave[wave_size++] = plugins[i];
+            plugins[i]        = NULL;
+        }
+
+        if (wave_size == 0) break;
+        registered += s_CommitWave(manager, wave, wave_size);
+    }
+
+    // whatever is left waits on a plugin outside the batch, or sits on a cycle
+    for (u64 i = 0; i < count; ++i) {
+        if (!plugins[i]) continue;
+
+        LNOTE("Plugin '%s' parked until its dependencies are registered.", filepaths[i]);
+        ALSAFE(&manager->mutex, s_Defer(manager, plugins[i], false););
+        s_DiscardPlugin(plugins[i]);
+    }
+
+    for (u64 i = 0; i < count; ++i) {
+        if (!skipped[i]) s_ReleasePath(manager, filepaths[i]);
+    }
+
+    free(plugins);
+    free(wave);
+    free(skipped);
+
+    LSUCCESS("Registered %llu of %llu plugins in one batch.", registered, count);
+
+    if (registered) s_RegisterReadyPending(manager);
+    return registered;
+}
+
+// swaps an initialized replacement into the slot of its uuid; 'previous' receives the
+// outgoing instance, which the caller retires
+static b8 s_SwapPlugin(AL_PluginManager* manager, AL_Plugin* replacement, AL_Plugin** previous) {
+    AL_Plugin* outgoing = NULL;
+    u64        slot     = 0;
+    b8         swapped  = false;
+    b8         handing  = false;
+
+    for (b8 busy = true; busy;) {
+        ALSAFE(&manager->mutex, {
+            busy = false;
+
+            if (!AL_HashMapFind(&manager->index, replacement->uuid, &slot)) {
+                swapped = s_InsertPlugin(manager, replacement);
+            } else if (manager->slots[slot].suspended) {
+                // another reload is handing off its state
+                busy = true;
+            } else {
+                outgoing = manager->slots[slot].plugin;
+                handing  = s_SuspendHandOffs(manager, &slot, &outgoing, &replacement, 1);
+                if (!handing) swapped = s_ReplaceInSlots(manager, &slot, &replacement, previous, 1);
+            }
+        });
+
+        if (busy) AL_Yield();
+    }
+
+    // the suspension keeps the slot holding 'outgoing' until it is swapped
+    if (handing) {
+        s_HandOffStates(manager, &outgoing, &replacement, 1);
+        ALSAFE(&manager->mutex, {
+            swapped = s_ReplaceInSlots(manager, &slot, &replacement, previous, 1);
+        });
+    }
+
+    if (!swapped || !outgoing) *previous = NULL;
+    if (swapped && (replacement->type & PLUGIN_ASYNC)) s_StartAsync(manager, replacement);
+    return swapped;
+}
+
+b8 AL_ReloadPlugin(AL_PluginManager* manager, const char* filepath) {
+    if (!filepath) {
+        LERROR("Cannot reload plugin with null filepath.");
+        return false;
+    }
+
+    if (!manager) {
+        LERROR("Cannot reload plugin '%s' with null plugin manager.", filepath);
         return false;
     }
 
-    manager->mutex    = AL_CreateMutex();
-    manager->registry = AL_Array(AL_Plugin, 0);
+    if (AL_QueryHandle(manager, filepath, false).generation == 0) {
+        return AL_AtomicLoad(&manager->lazy, AL_RELAXED)
+                   ? AL_RegisterPluginLazy(manager, filepath)
+                   : AL_RegisterPlugin(manager, filepath);
+    }
 
-    LSUCCESS("Plugin manager initialized succesfully.");
+    if (s_RefreshDormant(manager, filepath)) return true;
+
+    // the running instance keeps dispatching until its replacement is fully initialized
+    AL_Plugin* replacement = s_CreatePlugin(manager, filepath, true);
+    if (!replacement) {
+        LERROR("Reload of plugin '%s' failed; keeping the running instance.", filepath);
+        return false;
+    }
+
+    AL_Plugin* previous;
+    if (!s_SwapPlugin(manager, replacement, &previous)) {
+        LERROR("Could not swap in reloaded plugin '%s'.", filepath);
+        s_DestroyPlugin(replacement);
+        return false;
+    }
+
+    LSUCCESS("Plugin '%s' succesfully reloaded.", replacement->handle.filepath);
+
+    // only the affected subgraph is rebuilt, against the new instance, in init order
+    AL_String* dependents;
+    ALSAFE(&manager->mutex, {
+        AL_Plugin** plugins = s_CollectDependents(manager, replacement->uuid);
+        dependents          = AL_Array(AL_String, AL_Size(plugins));
+
+        AL_ForEach(plugins, i) {
+            // dormant ones are loaded against the new instance anyway
+            if (s_FindSlot(manager, plugins[i]->uuid)->dormant) continue;
+
+            const char* path = plugins[i]->handle.filepath;
+            AL_Append(dependents, AL_CopyC(path, strlen(path)));
+        }
+
+        AL_Free(plugins);
+    });
+
+    AL_Plugin** retired = AL_Array(AL_Plugin*, AL_Size(dependents) + 1);
+    AL_ForEach(dependents, i) {
+        // already parked along with a dependent that failed before it
+        if (AL_QueryHandle(manager, dependents[i], false).generation == 0) continue;
+
+        AL_Plugin* dependent = s_CreatePlugin(manager, dependents[i], true);
+        AL_Plugin* outgoing;
+
+        if (dependent && s_SwapPlugin(manager, dependent, &outgoing)) {
+            LSUCCESS("Dependent plugin '%s' succesfully reloaded.", dependents[i]);
+            if (outgoing) AL_Append(retired, outgoing);
+            continue;
+        }
+
+        // it must not keep running against the instance that is about to go away
+        LERROR("Dependent plugin '%s' could not be reloaded; unregistering.", dependents[i]);
+        if (dependent) s_DestroyPlugin(dependent);
+        AL_UnregisterPlugin(manager, dependents[i]);
+    }
+
+    // old instances go down dependents first, newest first
+    s_Reverse(retired);
+    if (previous) AL_Append(retired, previous);
+    s_RetirePlugins(manager, retired, AL_Size(retired));
+
+    AL_ForEach(dependents, i) AL_Free(dependents[i]);
+    AL_Free(dependents);
+    AL_Free(retired);
     return true;
 }
 
-b8 AL_DestroyPluginManager(AL_PluginManager* manager) {
-    if (!manager) return true;
-    assert(manager->registry != NULL);
+// reload transactions
 
-    AL_ForEach(manager->registry, i) AL_UnloadPlugin(manager->registry + i);
+// replacements initialized so far by this thread's commit, uuid -> plugin; resolving a plugin
+// that has one yields it, so dependents bind to the instances they will run against
+static AL_THREAD_LOCAL const AL_HashMap* s_staged = NULL;
 
-    AL_Free(manager->registry);
-    AL_DestroyMutex(&manager->mutex);
+b8 AL_BeginReload(AL_PluginManager* manager, AL_ReloadTransaction* transaction) {
+    if (!manager || !transaction) {
+        LERROR("Cannot begin a reload with a null plugin manager or transaction.");
+        return false;
+    }
 
-    LSUCCESS("Plugin manager destroyed succesfully.");
+    transaction->manager   = manager;
+    transaction->filepaths = AL_Array(AL_String, 0);
     return true;
 }
 
-b8 AL_RegisterPlugin(AL_PluginManager* manager, const char* filepath) {
-    if (!filepath) {
-        LERROR("Cannot register plugin with null filepath.");
+b8 AL_StageReload(AL_ReloadTransaction* transaction, const char* filepath) {
+    if (!transaction || !transaction->filepaths) {
+        LERROR("Cannot stage a reload into a transaction that was not begun.");
         return false;
     }
 
-    if (!manager) {
-        LERROR("Cannot register plugin '%s' with null plugin manager.", filepath);
+    if (!filepath) {
+        LERROR("Cannot stage reload of plugin with null filepath.");
         return false;
     }
 
-    AL_Plugin plugin;
-    if (!AL_LoadPlugin(filepath, &plugin)) {
-        LERROR("Could not load plugin '%s'.", filepath);
+    u64 hash = FNV_1A_C(filepath, strlen(filepath));
+    AL_ForEach(transaction->filepaths, i) {
+        if (*AL_Metadata(transaction->filepaths[i]) == hash) return true;
+    }
+
+    AL_String path     = AL_CopyC(filepath, strlen(filepath));
+    *AL_Metadata(path) = hash;
+    AL_Append(transaction->filepaths, path);
+    return true;
+}
+
+void AL_AbortReload(AL_ReloadTransaction* transaction) {
+    if (!transaction || !transaction->filepaths) return;
+
+    AL_ForEach(transaction->filepaths, i) AL_Free(transaction->filepaths[i]);
+    AL_Free(transaction->filepaths);
+    transaction->filepaths = NULL;
+}
+
+// the running instances of 'uuids' and of every plugin depending on one, in init order, as
+// the paths to load and the init sequence each instance had; dormant ones are left out.
+// mutex held
+static void s_CollectReloads(
+    AL_PluginManager* manager, const u64* uuids, AL_String** filepaths, u64** sequences
+) {
+    AL_Plugin** running = AL_Array(AL_Plugin*, AL_Size(uuids));
+    AL_HashMap  seen;
+
+    *filepaths          = AL_Array(AL_String, 0);
+    *sequences          = AL_Array(u64, 0);
+    if (!AL_CreateHashMap(AL_Size(manager->slots), &seen)) {
+        AL_Free(running);
+        return;
+    }
+
+    AL_ForEach(uuids, i) {
+        AL_PluginSlot* slot = s_FindSlot(manager, uuids[i]);
+        if (!slot || slot->dormant) continue;
+
+        AL_Plugin** affected = s_CollectDependents(manager, uuids[i]);
+        AL_Append(affected, slot->plugin);
+
+        AL_ForEach(affected, j) {
+            AL_Plugin* plugin = affected[j];
+            if (s_FindSlot(manager, plugin->uuid)->dormant) continue;
+            if (AL_HashMapFind(&seen, plugin->uuid, NULL)) continue;
+
+            AL_HashMapInsert(&seen, plugin->uuid, 0);
+            AL_Append(running, plugin);
+        }
+
+        AL_Free(affected);
+    }
+
+    qsort(running, AL_Size(running), sizeof(AL_Plugin*), s_CompareSequence);
+
+    AL_ForEach(running, i) {
+        const char* path = running[i]->handle.filepath;
+        AL_Append(*filepaths, AL_CopyC(path, strlen(path)));
+        AL_Append(*sequences, running[i]->sequence);
+    }
+
+    AL_DestroyHashMap(&seen);
+    AL_Free(running);
+}
+
+// swaps every replacement into the slot of its uuid with a single publish, or none if any of
+// the instances they replace has been unregistered or replaced since 'sequences' was taken;
+// 'running' receives the outgoing instances, which the caller retires
+static b8 s_SwapReloads(
+    AL_PluginManager* manager, AL_Plugin** replacements, const u64* sequences, u64 count,
+    AL_Plugin** running
+) {
+    u64* slots   = AL_Array(u64, count);
+    b8   swapped = false;
+    b8   handing = false;
+
+    for (b8 busy = true; busy;) {
+        ALSAFE(&manager->mutex, {
+            b8 current     = true;
+            busy           = false;
+            AL_Size(slots) = 0;
+
+            for (u64 i = 0; i < count && current; ++i) {
+                u64 slot;
+                current = AL_HashMapFind(&manager->index, replacements[i]->uuid, &slot) &&
+                          !manager->slots[slot].dormant &&
+                          manager->slots[slot].plugin->sequence == sequences[i];
+
+                if (!current) break;
+
+                // another reload is handing off its state
+                if (manager->slots[slot].suspended) busy = true;
+
+                running[i] = manager->slots[slot].plugin;
+                AL_Append(slots, slot);
+            }
+
+            if (!current) busy = false;
+            if (current && !busy) {
+                handing = s_SuspendHandOffs(manager, slots, running, replacements, count);
+                if (!handing)
+                    swapped = s_ReplaceInSlots(manager, slots, replacements, running, count);
+            }
+        });
+
+        if (busy) AL_Yield();
+    }
+
+    // the suspensions keep the slots holding 'running' until they are swapped
+    if (handing) {
+        s_HandOffStates(manager, running, replacements, count);
+        ALSAFE(&manager->mutex, {
+            swapped = s_ReplaceInSlots(manager, slots, replacements, running, count);
+        });
+    }
+
+    AL_Free(slots);
+    return swapped;
+}
+
+// reloads the running plugins 'filepaths' names, all or none; 'sequences' tells the instances
+// that were collected apart from any that replaced them since
+static b8 s_CommitReloads(AL_PluginManager* manager, AL_String* filepaths, const u64* sequences) {
+    u64         count        = AL_Size(filepaths);
+    AL_Plugin** replacements = calloc(count, sizeof(AL_Plugin*));
+    AL_Plugin** running      = calloc(count, sizeof(AL_Plugin*));
+    b8*         skipped      = calloc(count, sizeof(b8));
+    AL_HashMap  staged;
+
+    if (!replacements || !running || !skipped || !AL_CreateHashMap(count, &staged)) {
+        LERROR("Could not allocate reload of %llu plugins.", count);
+        free(replacements);
+        free(running);
+        free(skipped);
         return false;
     }
 
-    assert(plugin.init != NULL);
-    assert(manager->registry != NULL);
+    // the running instances keep dispatching until every replacement is initialized
+    PluginBatch batch = { .manager      = manager,
+                          .filepaths    = (const char* const*)filepaths,
+                          .plugins      = replacements,
+                          .skipped      = skipped,
+                          .side_by_side = true };
+    AL_ExecuteFor(&manager->executor, count, s_LoadPluginProc, &batch);
+
+    u64 initialized = 0;
+    s_staged        = &staged;
+    for (; initialized < count; ++initialized) {
+        AL_Plugin* replacement = replacements[initialized];
+        if (!replacement || !s_InitPlugin(manager, replacement)) break;
+
+        AL_HashMapInsert(&staged, replacement->uuid, (u64)replacement);
+    }
+
+    s_staged   = NULL;
+    b8 swapped = false;
+
+    if (initialized == count)
+        swapped = s_SwapReloads(manager, replacements, sequences, count, running);
+
+    if (swapped) {
+        for (u64 i = 0; i < count; ++i) {
+            if (replacements[i]->type & PLUGIN_ASYNC) s_StartAsync(manager, replacements[i]);
+        }
+
+        // old instances go down dependents first, newest first
+        for (u64 i = 0; i < count / 2; ++i) {
+            AL_Plugin* swap        = running[i];
+            running[i]             = running[count - i - 1];
+            running[count - i - 1] = swap;
+        }
+
+        s_RetirePlugins(manager, running, count);
+    } else {
+        // nothing of the new builds ever ran in dispatch; tear them down as if never loaded
+        for (u64 i = initialized; i-- > 0;) s_DestroyPlugin(replacements[i]);
+        for (u64 i = initialized; i < count; ++i) {
+            if (replacements[i]) s_DiscardPlugin(replacements[i]);
+        }
+    }
+
+    AL_DestroyHashMap(&staged);
+    free(replacements);
+    free(running);
+    free(skipped);
+    return swapped;
+}
 
-    if (!plugin.init(manager, &plugin)) {
-        LERROR("Initialization of plugin '%s' failed.", plugin.handle.filepath);
-        AL_UnloadPlugin(&plugin);
+b8 AL_CommitReload(AL_ReloadTransaction* transaction) {
+    if (!transaction || !transaction->manager || !transaction->filepaths) {
+        LERROR("Cannot commit a reload transaction that was not begun.");
         return false;
     }
 
-    ALSAFE(&manager->mutex, AL_Append(manager->registry, plugin););
-    LSUCCESS("Plugin '%s' succesfully registered.", plugin.handle.filepath);
+    AL_PluginManager* manager = transaction->manager;
+    AL_String*        staged  = transaction->filepaths;
+    const char**      fresh   = AL_Array(const char*, 0);
+    u64*              uuids   = AL_Array(u64, AL_Size(staged));
 
-    if (plugin.type & PLUGIN_ASYNC) AL_StartThread(&plugin.opt.thread);
-    return true;
+    AL_ForEach(staged, i) {
+        if (AL_QueryHandle(manager, staged[i], false).generation == 0)
+            AL_Append(fresh, staged[i]);
+        else if (!s_RefreshDormant(manager, staged[i]))
+            AL_Append(uuids, *AL_Metadata(staged[i]));
+    }
+
+    AL_String* filepaths = NULL;
+    u64*       sequences = NULL;
+    ALSAFE(&manager->mutex, s_CollectReloads(manager, uuids, &filepaths, &sequences););
+
+    u64 count     = AL_Size(filepaths);
+    b8  committed = count == 0 || s_CommitReloads(manager, filepaths, sequences);
+
+    if (count && committed)
+        LSUCCESS("Reloaded %llu plugins in one commit.", count);
+    else if (count)
+        LERROR("Reload of %llu plugins rolled back; keeping the running instances.", count);
+
+    if (AL_AtomicLoad(&manager->lazy, AL_RELAXED))
+        AL_ForEach(fresh, i) AL_RegisterPluginLazy(manager, fresh[i]);
+    else if (AL_Size(fresh))
+        AL_RegisterPlugins(manager, fresh, AL_Size(fresh));
+
+    AL_ForEach(filepaths, i) AL_Free(filepaths[i]);
+    AL_Free(filepaths);
+    AL_Free(sequences);
+    AL_Free(uuids);
+    AL_Free(fresh);
+    AL_AbortReload(transaction);
+    return committed;
 }
 
 b8 AL_UnregisterPlugin(AL_PluginManager* manager, const char* filepath) {
@@ -82,44 +1737,493 @@ b8 AL_UnregisterPlugin(AL_PluginManager* manager, const char* filepath) {
         return false;
     }
 
-    u64 hash = FNV_1A_C(filepath, strlen(filepath));
-    assert(manager->registry != NULL);
+    u64         hash      = FNV_1A_C(filepath, strlen(filepath));
+    AL_Plugin** retired   = NULL;
+    b8          published = false;
 
-    AL_ForEach(manager->registry, i) {
-        AL_Plugin* plugin = manager->registry + i;
+    for (;;) {
+        b8 busy;
 
-        if (plugin->uuid == hash) {
-            ALSAFE(&manager->mutex, {
-                AL_UnloadPlugin(plugin);
-                AL_Remove(manager->registry, i);
-            });
-            return true;
-        }
+        ALSAFE(&manager->mutex, {
+            u64 slot = 0;
+            busy     = false;
+
+            if (AL_HashMapFind(&manager->index, hash, &slot)) {
+                // dependents go first, newest first, and are parked until it comes back
+                retired = s_CollectDependents(manager, hash);
+                s_Reverse(retired);
+                AL_Append(retired, manager->slots[slot].plugin);
+
+                // a reload is still reading the state of one of them
+                busy = s_AnyHandingOff(manager, retired);
+            }
+
+            for (u64 i = 0; retired && !busy && i + 1 < AL_Size(retired); ++i) {
+                LNOTE("Dependent plugin '%s' parked.", retired[i]->handle.filepath);
+                s_Defer(manager, retired[i], s_FindSlot(manager, retired[i]->uuid)->lazy);
+                s_UnindexPlugin(manager, retired[i]);
+            }
+
+            if (retired && !busy) {
+                s_UnindexPlugin(manager, manager->slots[slot].plugin);
+
+                published = s_PublishRegistry(manager);
+                if (!published)
+                    LERROR("Could not publish registry; plugin '%s' leaked.", filepath);
+            }
+        });
+
+        if (!busy) break;
+
+        AL_Free(retired);
+        retired = NULL;
+        AL_Yield();
+    }
+
+    if (retired) {
+        if (published) s_RetirePlugins(manager, retired, AL_Size(retired));
+        AL_Free(retired);
+        return true;
     }
 
     LERROR("Plugin '%s' not found within registry; cannot unregister.", filepath);
     return false;
 }
 
-AL_Plugin* AL_Query(AL_PluginManager* manager, const char* filepath, b8 required) {
+const AL_Registry* AL_AcquireRegistry(AL_PluginManager* manager) {
+    assert(manager != NULL);
+
+    AL_EnterEpoch(&manager->epoch);
+    return AL_AtomicLoad(&manager->registry, AL_ACQUIRE);
+}
+
+void AL_ReleaseRegistry(AL_PluginManager* manager) {
+    assert(manager != NULL);
+    AL_ExitEpoch(&manager->epoch);
+}
+
+// periodic dispatch; only the dispatching thread touches this state
+
+static void s_SchedulePeriodic(AL_PeriodicState* state, AL_PeriodicTimer* timer, u64 now) {
+    u64 frames = timer->period;
+
+    // milliseconds map onto frames through the smoothed frame length, and are checked on expiry
+    if (timer->period_ms) {
+        u64 remaining = timer->due_ns > now ? timer->due_ns - now : 0;
+        frames        = state->frame_ns ? remaining / state->frame_ns : 1;
+    }
+
+    AL_ScheduleTimer(&state->wheel, &timer->timer, state->wheel.now + (frames ? frames : 1));
+}
+
+static void s_DestroyPeriodic(AL_PeriodicState* state, AL_PeriodicTimer* timer) {
+    AL_CancelTimer(&state->wheel, &timer->timer);
+    AL_HashMapErase(&state->timers, timer->uuid);
+
+    u64 kept = 0;
+    AL_ForEach(state->due, i) {
+        if (state->due[i] != timer) state->due[kept++] = state->due[i];
+    }
+
+    AL_Size(state->due) = kept;
+    free(timer);
+}
+
+// follows the snapshot: new periodic plugins are due right away, reloaded ones keep their
+// schedule unless their period changed, removed ones are dropped
+static void s_SyncPeriodic(AL_PeriodicState* state, const AL_Registry* registry, u64 now) {
+    if (state->version == registry->version) return;
+    state->version = registry->version;
+
+    for (u64 i = 0; i < state->timers.capacity; ++i) {
+        AL_HashEntry* entry = state->timers.entries + i;
+        if (entry->key != AL_HASHMAP_EMPTY_KEY) ((AL_PeriodicTimer*)entry->value)->live = false;
+    }
+
+    AL_ForEach(registry->periodic, i) {
+        AL_Plugin*        plugin = registry->periodic[i];
+        AL_PeriodicTimer* timer  = NULL;
+        u64               value;
+
+        if (AL_HashMapFind(&state->timers, plugin->uuid, &value)) {
+            timer         = (AL_PeriodicTimer*)value;
+            timer->plugin = plugin;
+            timer->live   = true;
+
+            if (timer->period == plugin->period && timer->period_ms == plugin->period_ms) continue;
+            AL_CancelTimer(&state->wheel, &timer->timer);
+        } else {
+            timer = calloc(1, sizeof(AL_PeriodicTimer));
+            if (!timer) {
+                LERROR("Could not schedule plugin '%s'.", plugin->handle.filepath);
+                continue;
+            }
+
+            timer->plugin = plugin;
+            timer->uuid   = plugin->uuid;
+            timer->live   = true;
+            AL_HashMapInsert(&state->timers, plugin->uuid, (u64)timer);
+        }
+
+        timer->period    = plugin->period;
+        timer->period_ms = plugin->period_ms;
+        timer->due_ns    = now;
+        AL_ScheduleTimer(&state->wheel, &timer->timer, state->wheel.now);
+    }
+
+    AL_PeriodicTimer** stale = AL_Array(AL_PeriodicTimer*, 0);
+    for (u64 i = 0; i < state->timers.capacity; ++i) {
+        AL_HashEntry*     entry = state->timers.entries + i;
+        AL_PeriodicTimer* timer = (AL_PeriodicTimer*)entry->value;
+        if (entry->key != AL_HASHMAP_EMPTY_KEY && !timer->live) AL_Append(stale, timer);
+    }
+
+    AL_ForEach(stale, i) s_DestroyPeriodic(state, stale[i]);
+    AL_Free(stale);
+}
+
+static int s_CompareDue(const void* lhs, const void* rhs) {
+    const AL_Plugin* a = (*(AL_PeriodicTimer* const*)lhs)->plugin;
+    const AL_Plugin* b = (*(AL_PeriodicTimer* const*)rhs)->plugin;
+    return s_CompareDispatch(&a, &b);
+}
+
+static void s_AdvancePeriodic(AL_PeriodicState* state, const AL_Registry* registry, u64 frame) {
+    if (AL_Size(registry->periodic) == 0 && state->timers.count == 0) return;
+
+    u64 now = AL_GetTime();
+
+    // the snapshot changed between two phases of the same frame
+    if (state->started && state->frame == frame) {
+        s_SyncPeriodic(state, registry, now);
+        return;
+    }
+
+    if (state->started && frame > state->frame) {
+        u64 frame_ns    = (now - state->last_ns) / (frame - state->frame);
+        state->frame_ns = state->frame_ns ? (state->frame_ns * 7 + frame_ns) / 8 : frame_ns;
+    } else if (!state->started) {
+        state->wheel.now = frame;
+    }
+
+    state->started      = true;
+    state->frame        = frame;
+    state->last_ns      = now;
+    AL_Size(state->due) = 0;
+
+    s_SyncPeriodic(state, registry, now);
+
+    AL_Timer* expired = AL_AdvanceTimingWheel(&state->wheel, frame + 1);
+    while (expired) {
+        AL_PeriodicTimer* timer = (AL_PeriodicTimer*)expired;
+        expired                 = expired->next;
+
+        if (timer->period_ms) {
+            // the frame length estimate ran ahead; wait out the rest
+            if (now + state->frame_ns / 2 < timer->due_ns) {
+                s_SchedulePeriodic(state, timer, now);
+                continue;
+            }
+
+            timer->due_ns += timer->period_ms * AL_NS_PER_MS;
+            if (timer->due_ns <= now) timer->due_ns = now + timer->period_ms * AL_NS_PER_MS;
+        }
+
+        s_SchedulePeriodic(state, timer, now);
+        AL_Append(state->due, timer);
+    }
+
+    qsort(state->due, AL_Size(state->due), sizeof(AL_PeriodicTimer*), s_CompareDue);
+}
+
+// update timing; each plugin's stats are only ever written by the thread running its update
+
+static void s_RecordUpdate(AL_UpdateStats* stats, u64 elapsed, u64 budget) {
+    AL_RecordValue(&stats->histogram, elapsed);
+
+    u64 limit = stats->budget_ns ? stats->budget_ns : budget;
+    AL_AtomicStore(&stats->total_ns, stats->total_ns + elapsed, AL_RELAXED);
+    if (elapsed > stats->max_ns) AL_AtomicStore(&stats->max_ns, elapsed, AL_RELAXED);
+    if (limit && elapsed > limit) AL_AtomicStore(&stats->overruns, stats->overruns + 1, AL_RELAXED);
+}
+
+// read once per dispatch, so while all are off the loops below stay as they were
+typedef struct {
+    b8  sampling;
+    b8  tracing;
+    b8  watched;
+    u64 budget;
+} UpdateTiming;
+
+static inline void s_TimeUpdate(
+    PFN_plugin_update_t update, AL_UpdateStats* stats, u64 frame, const UpdateTiming* timing
+) {
+    u64 start = AL_GetTime();
+    if (timing->watched) AL_AtomicStore(&stats->running, start, AL_RELAXED);
+
+    update(frame);
+
+    u64 end = AL_GetTime();
+    if (timing->watched) AL_AtomicStore(&stats->running, 0, AL_RELAXED);
+
+    if (timing->sampling) s_RecordUpdate(stats, end - start, timing->budget);
+    if (timing->tracing) AL_TraceSpan("update", stats->uuid, start, end);
+}
+
+static UpdateTiming s_ReadTiming(AL_PluginManager* manager) {
+    return (UpdateTiming){ .sampling = AL_AtomicLoad(&manager->sampling, AL_RELAXED),
+                           .tracing  = AL_IsTracing(),
+                           .watched  = AL_AtomicLoad(&manager->update_deadline_ms, AL_RELAXED) != 0,
+                           .budget   = AL_AtomicLoad(&manager->budget_ns, AL_RELAXED) };
+}
+
+typedef struct {
+    const PFN_plugin_update_t* updates;
+    AL_UpdateStats* const*     stats;
+    u64                        frame;
+    UpdateTiming               timing;
+} UpdateBatch;
+
+static void s_UpdateProc(u64 index, void* argument) {
+    UpdateBatch* batch = argument;
+
+    if (batch->timing.sampling || batch->timing.tracing || batch->timing.watched)
+        s_TimeUpdate(batch->updates[index], batch->stats[index], batch->frame, &batch->timing);
+    else
+        batch->updates[index](batch->frame);
+}
+
+static void s_DispatchPhase(
+    AL_PluginManager* manager, const AL_Registry* registry, enum PluginPhase phase, u64 frame,
+    const UpdateTiming* timing
+) {
+    UpdateBatch batch = { .updates = registry->parallel[phase],
+                          .stats   = registry->parallel_stats[phase],
+                          .frame   = frame,
+                          .timing  = *timing };
+    AL_ExecuteFor(&manager->executor, AL_Size(batch.updates), s_UpdateProc, &batch);
+
+    const PFN_plugin_update_t* updates = registry->updates[phase];
+    AL_UpdateStats* const*     stats   = registry->stats[phase];
+    u64                        count   = AL_Size(updates);
+    b8                         timed   = timing->sampling || timing->tracing || timing->watched;
+
+    AL_PeriodicTimer**         due     = manager->periodic.due;
+    u64                        next    = 0;
+    while (next < AL_Size(due) && due[next]->plugin->phase < phase) ++next;
+
+    if (next == AL_Size(due) || due[next]->plugin->phase != phase) {
+        if (!timed) {
+            for (u64 i = 0; i < count; ++i) updates[i](frame);
+            return;
+        }
+
+        for (u64 i = 0; i < count; ++i) s_TimeUpdate(updates[i], stats[i], frame, timing);
+        return;
+    }
+
+    // both lists are in priority order; merge them
+    const i32* priorities = registry->priorities[phase];
+    for (u64 i = 0; i < count || next < AL_Size(due);) {
+        b8 periodic = next < AL_Size(due) && due[next]->plugin->phase == phase &&
+                      (i == count || due[next]->plugin->priority < priorities[i]);
+
+        PFN_plugin_update_t update;
+        AL_UpdateStats*     record;
+
+        if (periodic) {
+            update = due[next]->plugin->opt.update;
+            record = due[next++]->plugin->stats;
+        } else if (i < count) {
+            update = updates[i];
+            record = stats[i++];
+        } else {
+            break;
+        }
+
+        if (timed) s_TimeUpdate(update, record, frame, timing);
+        else
+            update(frame);
+    }
+}
+
+// wakes dormant plugins whose update is due, outside the epoch, and returns the new snapshot
+static const AL_Registry* s_WakeDue(AL_PluginManager* manager, const AL_Registry* registry) {
+    u64* due = AL_CloneArray(registry->dormant);
+    AL_ReleaseRegistry(manager);
+
+    AL_ForEach(due, i) s_WakePlugin(manager, due[i]);
+    AL_Free(due);
+
+    return AL_AcquireRegistry(manager);
+}
+
+void AL_DispatchPhase(AL_PluginManager* manager, enum PluginPhase phase, u64 frame) {
+    assert(phase < PHASE_COUNT);
+
+    UpdateTiming       timing   = s_ReadTiming(manager);
+    const AL_Registry* registry = AL_AcquireRegistry(manager);
+    if (AL_Size(registry->dormant)) registry = s_WakeDue(manager, registry);
+
+    s_AdvancePeriodic(&manager->periodic, registry, frame);
+    s_DispatchPhase(manager, registry, phase, frame, &timing);
+    AL_ReleaseRegistry(manager);
+}
+
+void AL_DispatchUpdate(AL_PluginManager* manager, u64 frame) {
+    UpdateTiming       timing   = s_ReadTiming(manager);
+    const AL_Registry* registry = AL_AcquireRegistry(manager);
+    if (AL_Size(registry->dormant)) registry = s_WakeDue(manager, registry);
+
+    s_AdvancePeriodic(&manager->periodic, registry, frame);
+
+    for (u32 phase = 0; phase < PHASE_COUNT; ++phase)
+        s_DispatchPhase(manager, registry, phase, frame, &timing);
+
+    AL_ReleaseRegistry(manager);
+}
+
+void AL_SetSampling(AL_PluginManager* manager, b8 enabled) {
+    assert(manager != NULL);
+    AL_AtomicStore(&manager->sampling, enabled, AL_RELAXED);
+}
+
+void AL_SetUpdateBudget(AL_PluginManager* manager, u64 budget_ns) {
+    assert(manager != NULL);
+    AL_AtomicStore(&manager->budget_ns, budget_ns, AL_RELAXED);
+}
+
+void AL_SetWatchdog(AL_PluginManager* manager, u32 update_deadline_ms, u32 heartbeat_deadline_ms) {
+    assert(manager != NULL);
+    AL_AtomicStore(&manager->update_deadline_ms, update_deadline_ms, AL_RELAXED);
+    AL_AtomicStore(&manager->heartbeat_deadline_ms, heartbeat_deadline_ms, AL_RELAXED);
+}
+
+void AL_SetIdleUnload(AL_PluginManager* manager, u32 idle_ms) {
+    assert(manager != NULL);
+    AL_AtomicStore(&manager->idle_ms, idle_ms, AL_RELAXED);
+}
+
+void AL_SetLazyLoading(AL_PluginManager* manager, b8 enabled) {
+    assert(manager != NULL);
+    AL_AtomicStore(&manager->lazy, enabled, AL_RELAXED);
+}
+
+b8 AL_OpenMetadataCache(AL_PluginManager* manager, const char* filepath) {
+    if (!manager || !filepath) {
+        LERROR("Cannot open a metadata cache with a null plugin manager or filepath.");
+        return false;
+    }
+
+    if (manager->cache.filepath) {
+        LERROR("Plugin manager already has metadata cache '%s'.", manager->cache.filepath);
+        return false;
+    }
+
+    return AL_OpenPluginCache(filepath, &manager->cache);
+}
+
+b8 AL_GetPluginStats(AL_PluginManager* manager, const char* filepath, AL_PluginStats* stats) {
+    if (!manager || !filepath || !stats) {
+        LERROR("Cannot get plugin stats with a null manager, filepath or output.");
+        return false;
+    }
+
+    u64                hash     = FNV_1A_C(filepath, strlen(filepath));
+    b8                 found    = false;
+
+    const AL_Registry* registry = AL_AcquireRegistry(manager);
+
+    u64                slot;
+    if (AL_HashMapFind(&registry->index, hash, &slot) && registry->slots[slot].plugin) {
+        // read while the dispatching thread may be recording; each field is only ever torn
+        // against the others, never within itself
+        const AL_UpdateStats* timing = registry->slots[slot].plugin->stats;
+
+        stats->calls    = AL_HistogramCount(&timing->histogram);
+        stats->overruns = AL_AtomicLoad(&timing->overruns, AL_RELAXED);
+        stats->max_ns   = AL_AtomicLoad(&timing->max_ns, AL_RELAXED);
+        stats->mean_ns  = stats->calls ? AL_AtomicLoad(&timing->total_ns, AL_RELAXED) / stats->calls
+                                       : 0;
+        stats->p50_ns   = AL_HistogramQuantile(&timing->histogram, 0.50);
+        stats->p90_ns   = AL_HistogramQuantile(&timing->histogram, 0.90);
+        stats->p99_ns   = AL_HistogramQuantile(&timing->histogram, 0.99);
+        stats->stalls   = AL_AtomicLoad(&timing->stalls, AL_RELAXED);
+        found           = true;
+    }
+
+    AL_ReleaseRegistry(manager);
+
+    if (!found) LERROR("Plugin '%s' not found within registry; no stats.", filepath);
+    return found;
+}
+
+AL_PluginHandle AL_QueryHandle(AL_PluginManager* manager, const char* filepath, b8 required) {
     if (!manager) {
         LERROR("Cannot query with a null plugin manager.");
-        return NULL;
+        return AL_NULL_HANDLE;
     }
 
     if (!filepath) {
         LERROR("Cannot query plugin registry with null name.");
-        return NULL;
+        return AL_NULL_HANDLE;
     }
 
-    assert(manager->registry != NULL);
-    u64 hash = FNV_1A_C(filepath, strlen(filepath));
+    u64                hash     = FNV_1A_C(filepath, strlen(filepath));
+    AL_PluginHandle    handle   = AL_NULL_HANDLE;
+
+    const AL_Registry* registry = AL_AcquireRegistry(manager);
 
-    AL_ForEach(manager->registry, i) {
-        AL_Plugin* plugin = manager->registry + i;
-        if (plugin->uuid == hash) return plugin;
+    u64                slot;
+    if (AL_HashMapFind(&registry->index, hash, &slot)) {
+        handle = (AL_PluginHandle){ .index = slot, .generation = registry->slots[slot].generation };
     }
 
-    if (required) LERROR("Plugin '%s' not found from register.", filepath);
-    return NULL;
+    AL_ReleaseRegistry(manager);
+
+    if (required && handle.generation == 0)
+        LERROR("Plugin '%s' not found from register.", filepath);
+    return handle;
+}
+
+// the returned plugin is only guaranteed to live until it is unregistered
+AL_Plugin* AL_Query(AL_PluginManager* manager, const char* filepath, b8 required) {
+    return AL_Resolve(manager, AL_QueryHandle(manager, filepath, required));
+}
+
+// without loading; 'dormant' receives the uuid of a dormant plugin, else 0
+static AL_Plugin* s_Resolve(AL_PluginManager* manager, AL_PluginHandle handle, u64* dormant) {
+    AL_Plugin*         plugin   = NULL;
+    const AL_Registry* registry = AL_AcquireRegistry(manager);
+    *dormant                    = 0;
+
+    if (handle.index < AL_Size(registry->slots)) {
+        AL_PluginSlot* slot = registry->slots + handle.index;
+
+        if (slot->generation == handle.generation && slot->dormant)
+            *dormant = slot->plugin->uuid;
+        else if (slot->generation == handle.generation)
+            plugin = slot->plugin;
+
+        // idle time runs from the last resolve
+        if (plugin && slot->lazy) AL_AtomicStore(&plugin->used, AL_GetTime(), AL_RELAXED);
+    }
+
+    u64 replacement;
+    if (plugin && s_staged && AL_HashMapFind(s_staged, plugin->uuid, &replacement))
+        plugin = (AL_Plugin*)replacement;
+
+    AL_ReleaseRegistry(manager);
+    return plugin;
+}
+
+AL_Plugin* AL_Resolve(AL_PluginManager* manager, AL_PluginHandle handle) {
+    if (!manager) return NULL;
+
+    u64        dormant;
+    AL_Plugin* plugin = s_Resolve(manager, handle, &dormant);
+
+    // first use of a lazily registered plugin
+    if (dormant && s_WakePlugin(manager, dormant)) plugin = s_Resolve(manager, handle, &dormant);
+    return plugin;
 }
@@ -2,22 +2,255 @@
 #define AL_MANAGER_H_
 
 #include "aldefs.h"
+#include "epoch.h"
+#include "executor.h"
+#include "hashmap.h"
+#include "histogram.h"
 #include "plugin.h"
+#include "plugincache.h"
+#include "reactor.h"
 #include "threads.h"
+#include "timingwheel.h"
+
+#define AL_INVALID_SLOT       0xffffffff
+#define AL_WATCHDOG_PERIOD_MS 50
+
+// stays valid across registry growth and other plugins' removal; goes stale
+// (resolves to null) once the plugin it names is unregistered
+typedef struct AL_PluginHandle_ {
+    u32 index;
+    u32 generation; // 0 is never live
+} AL_PluginHandle;
+
+#define AL_NULL_HANDLE ((AL_PluginHandle){ .index = AL_INVALID_SLOT, .generation = 0 })
+
+typedef struct AL_PluginSlot_ {
+    AL_Plugin* plugin; // null while on the free list
+    u32        generation;
+    u32        next_free;
+    b8         suspended;   // registered, but left out of dispatch
+    b8         quarantined; // stalled; left out of dispatch until reloaded
+    b8         lazy;        // loaded on first use, and unloaded again once idle
+    b8         dormant;     // lazy and not loaded; 'plugin' holds its metadata only
+} AL_PluginSlot;
+
+// per-plugin update timings, recorded only while the manager is sampling
+typedef struct AL_UpdateStats_ {
+    AL_Histogram histogram; // update durations, ns
+    u64          total_ns;
+    u64          max_ns;
+    u64          overruns;  // updates over budget
+    u64          budget_ns; // the plugin's own, 0 for the manager's
+    u64          uuid;      // of the plugin, names its trace spans
+    u64          running;   // atomic, start of the update in flight while watched, else 0
+    u64          flagged;   // watchdog only, start of the last stall reported
+    u64          stalls;    // atomic
+} AL_UpdateStats;
+
+typedef struct AL_PluginStats_ {
+    u64 calls;
+    u64 overruns;
+    u64 mean_ns;
+    u64 max_ns;
+    u64 p50_ns; // percentiles are bucket upper bounds, within 25%
+    u64 p90_ns;
+    u64 p99_ns;
+    u64 stalls; // deadlines missed, as seen by the watchdog
+} AL_PluginStats;
+
+// immutable view of the registry, published by writers and read inside the manager's epoch
+typedef struct AL_Registry_ {
+    AL_PluginSlot*       slots;                       // array, copy of the slot map
+    AL_Plugin**          plugins;                     // array, live plugins, packed
+    PFN_plugin_update_t* updates[PHASE_COUNT];        // arrays, sync update entry points in
+                                                      // dispatch order: by priority, then uuid
+    i32*                 priorities[PHASE_COUNT];     // arrays, parallel to 'updates'
+    AL_UpdateStats**     stats[PHASE_COUNT];          // arrays, parallel to 'updates'
+    PFN_plugin_update_t* parallel[PHASE_COUNT];       // arrays, PLUGIN_PARALLEL updates,
+                                                      // fanned out before each phase's serial ones
+    AL_UpdateStats**     parallel_stats[PHASE_COUNT]; // arrays, parallel to 'parallel'
+    AL_Plugin**          periodic;                    // array, plugins with a period; they
+                                                      // run off the manager's timing wheel
+    u64*                 dormant;                     // array, uuids of dormant plugins with an
+                                                      // update or thread; dispatch wakes them
+    AL_HashMap           index;                       // uuid -> slot index
+    u64                  version;                     // bumped on every publish
+} AL_Registry;
+
+typedef struct AL_PeriodicTimer_ {
+    AL_Timer   timer;  // first, so expired timers cast back
+    AL_Plugin* plugin; // instance in the last synced snapshot
+    u64        uuid;
+    u32        period;
+    u32        period_ms;
+    u64        due_ns; // next deadline of a 'period_ms' plugin
+    b8         live;
+} AL_PeriodicTimer;
+
+// plugins with a 'period' sit in a timing wheel ticked by the frame index, so a frame only
+// touches the ones that are due. owned by whichever thread dispatches updates.
+typedef struct AL_PeriodicState_ {
+    AL_TimingWheel     wheel;    // ticks are frame + 1
+    AL_HashMap         timers;   // uuid -> AL_PeriodicTimer*
+    AL_PeriodicTimer** due;      // array, timers due this frame in dispatch order
+    u64                version;  // registry version the timers were synced to
+    u64                frame;    // last frame the wheel was advanced to
+    u64                frame_ns; // smoothed frame length, maps 'period_ms' onto frames
+    u64                last_ns;
+    b8                 started;
+} AL_PeriodicState;
+
+// a plugin waiting for its dependencies to be registered
+typedef struct AL_PendingPlugin_ {
+    AL_String filepath;
+    u64*      dependencies; // array of uuids
+    b8        lazy;
+} AL_PendingPlugin;
 
 typedef struct AL_PluginManager_ {
-    AL_Mutex   mutex;
-    AL_Plugin* registry;
+    AL_Mutex          mutex;     // serializes writers
+    AL_PluginSlot*    slots;     // writer-side slot map; slots are reused, never shifted
+    AL_HashMap        index;     // writer-side uuid -> slot index
+    u32               free_slot; // head of the free list
+
+    AL_PendingPlugin* pending;     // array, guarded by the mutex
+    AL_HashMap        registering; // uuids of paths being registered, guarded by the mutex
+    u64               sequence;    // last init order handed out
+
+    AL_Epoch          epoch;
+    AL_Registry*      registry; // current snapshot
+
+    AL_Executor       executor; // runs PLUGIN_PARALLEL updates and async plugins' steps
+    AL_Reactor        reactor;  // plugins waiting on descriptors register them here
+    AL_PeriodicState  periodic;
+
+    b8                sampling;  // atomic
+    u64               budget_ns; // atomic, default per-update budget
+
+    AL_Thread         watchdog;
+    u32               update_deadline_ms;    // atomic, 0 stops watching updates
+    u32               heartbeat_deadline_ms; // atomic, 0 stops watching async plugins
+    u64               stalled;               // atomic, updates in flight past their deadline
+
+    AL_HashMap        waking;  // uuids of dormant plugins being loaded, guarded by the mutex
+    u32               idle_ms; // atomic, 0 keeps woken lazy plugins loaded
+    b8                lazy;    // atomic, paths reloads find unregistered are registered lazily
+
+    AL_PluginCache    cache; // metadata of plugin files across runs; closed unless opened
 } AL_PluginManager;
 
-ALAPI b8         AL_CreatePluginManager(AL_PluginManager* manager);
+// plugins staged to be reloaded together; used by one thread at a time
+typedef struct AL_ReloadTransaction_ {
+    AL_PluginManager* manager;
+    AL_String*        filepaths; // array, staged, each path once
+} AL_ReloadTransaction;
+
+ALAPI b8                 AL_CreatePluginManager(AL_PluginManager* manager);
+
+// tears plugins down in reverse init order, dependents before their dependencies
+ALAPI b8                 AL_DestroyPluginManager(AL_PluginManager* manager);
+
+// a plugin whose 'dependencies' are not all registered yet is parked, and registered as
+// soon as the last of them is
+ALAPI b8                 AL_RegisterPlugin(AL_PluginManager* manager, const char* filepath);
+
+// loads every plugin in parallel, then initializes them wave by wave in dependency order,
+// each wave in parallel and committed with a single registry publish; returns how many
+// were registered
+ALAPI u64                AL_RegisterPlugins(
+    AL_PluginManager* manager, const char* const* filepaths, u64 count
+);
+
+// records the plugin's metadata only; it is loaded and initialized on its first AL_Query or
+// AL_Resolve, or by the first dispatch if it has an update or a thread. its dependencies
+// are woken first.
+ALAPI b8                 AL_RegisterPluginLazy(AL_PluginManager* manager, const char* filepath);
+
+// plugins depending on it are unregistered first and parked until it comes back
+ALAPI b8                 AL_UnregisterPlugin(AL_PluginManager* manager, const char* filepath);
+
+// loads and initializes the new build next to the running one, swaps it into the same
+// slot with a single snapshot publish, then tears the old instance down; on failure the
+// running instance is kept. if both builds export 'save_state'/'restore_state', the old
+// instance is suspended for one frame and its state block is passed to the new one.
+// plugins depending on it are reloaded after it, in init order.
+ALAPI b8                 AL_ReloadPlugin(AL_PluginManager* manager, const char* filepath);
+
+ALAPI b8                 AL_BeginReload(
+    AL_PluginManager* manager, AL_ReloadTransaction* transaction
+);
+
+// nothing is loaded until the transaction is committed
+ALAPI b8                 AL_StageReload(AL_ReloadTransaction* transaction, const char* filepath);
+
+// loads new builds of every staged plugin and of every plugin depending on one, side by side
+// and in parallel, then initializes them in init order, each seeing the new instances of its
+// dependencies. if all of them make it, they are swapped in with a single registry publish and
+// the old instances torn down, dependents first; otherwise every replacement is torn down and
+// the running instances are kept. staged paths that aren't registered yet are registered as
+// a batch afterwards, or lazily one by one with lazy loading on. ends the transaction.
+ALAPI b8                 AL_CommitReload(AL_ReloadTransaction* transaction);
+
+// ends the transaction without loading anything
+ALAPI void               AL_AbortReload(AL_ReloadTransaction* transaction);
+
+// wait-free; the snapshot and its plugins stay valid until the matching release
+ALAPI const AL_Registry* AL_AcquireRegistry(AL_PluginManager* manager);
+
+ALAPI void               AL_ReleaseRegistry(AL_PluginManager* manager);
+
+// runs one phase of the live synchronous plugins' 'update' off the current snapshot: the
+// PLUGIN_PARALLEL ones across the manager's executor, joined, then the rest in order. plugins
+// with a period run serially among the rest when due, after any of equal priority. frames
+// must not go backwards, and only one thread may dispatch.
+ALAPI void               AL_DispatchPhase(
+    AL_PluginManager* manager, enum PluginPhase phase, u64 frame
+);
+
+// runs every phase in order, off a single snapshot
+ALAPI void               AL_DispatchUpdate(AL_PluginManager* manager, u64 frame);
+
+// switches update timing on or off; while off, dispatch does no per-plugin work for it
+ALAPI void               AL_SetSampling(AL_PluginManager* manager, b8 enabled);
+
+// budget for plugins without their own 'budget_us'; 0 stops counting their overruns
+ALAPI void               AL_SetUpdateBudget(AL_PluginManager* manager, u64 budget_ns);
+
+// sets how long an update may run, and an async plugin go without reading its sync flag,
+// before the watchdog reports a stall and quarantines the plugin until it is reloaded; a
+// plugin's own 'deadline_ms' overrides either. 0 stops watching; watching updates costs two
+// clock reads per update. a stuck update can't be interrupted, but while it is stuck reloads
+// and unregistrations defer unloading instead of waiting on it.
+ALAPI void               AL_SetWatchdog(
+    AL_PluginManager* manager, u32 update_deadline_ms, u32 heartbeat_deadline_ms
+);
+
+// unloads lazily registered plugins without an update or a thread once nothing resolved them
+// for 'idle_ms', unless a loaded plugin depends on them; the next use loads them again. like
+// unregistering, that invalidates pointers to them, so users of idle ones should keep a
+// handle and resolve it each time. 0 keeps them loaded.
+ALAPI void               AL_SetIdleUnload(AL_PluginManager* manager, u32 idle_ms);
+
+// with it on, AL_ReloadPlugin and AL_CommitReload register the paths that aren't registered
+// yet through AL_RegisterPluginLazy, so plugins already on disk when a watcher starts up are
+// not loaded until used. off by default.
+ALAPI void               AL_SetLazyLoading(AL_PluginManager* manager, b8 enabled);
+
+// keeps plugins' metadata in 'filepath' across runs, so an unchanged plugin is loaded or
+// registered lazily without reading its descriptor or exports again; written back when the
+// manager is destroyed. call it before registering any plugin.
+ALAPI b8                 AL_OpenMetadataCache(AL_PluginManager* manager, const char* filepath);
 
-ALAPI b8         AL_DestroyPluginManager(AL_PluginManager* manager);
+// timings of the plugin's current instance, since it was loaded
+ALAPI b8                 AL_GetPluginStats(
+    AL_PluginManager* manager, const char* filepath, AL_PluginStats* stats
+);
 
-ALAPI b8         AL_RegisterPlugin(AL_PluginManager* manager, const char* filepath);
+ALAPI AL_Plugin*         AL_Query(AL_PluginManager* manager, const char* name, b8 required);
 
-ALAPI b8         AL_UnregisterPlugin(AL_PluginManager* manager, const char* filepath);
+ALAPI AL_PluginHandle    AL_QueryHandle(AL_PluginManager* manager, const char* name, b8 required);
 
-ALAPI AL_Plugin* AL_Query(AL_PluginManager* manager, const char* name, b8 required);
+// O(1), unless it loads a dormant lazy plugin; null if the handle is stale
+ALAPI AL_Plugin*         AL_Resolve(AL_PluginManager* manager, AL_PluginHandle handle);
 
 #endif
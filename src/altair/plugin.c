@@ -5,30 +5,79 @@
 
 #include "aldefs.h"
 #include "array.h"
+#include "clock.h"
+#include "coroutine.h"
 #include "dll.h"
 #include "hash.h"
+#include "host.h"
 #include "log.h"
+#include "trace.h"
 
 static u32 s_DefaultIdleUpdate(u64 _) { return 0; }
 
-b8         AL_LoadPlugin(const char* filepath, AL_Plugin* plugin) {
-    if (!filepath) {
-        LERROR("Invalid plugin filepath; loading failed.");
-        return false;
-    }
+// the step of a PLUGIN_COROUTINE plugin: runs 'proc' until it blocks, then waits out the block,
+// or parks until whatever it blocked on wakes it
+static u32 s_ResumeProc(AL_Plugin* plugin) {
+    if (!AL_ResumeCoroutine(&plugin->coroutine)) return AL_STEP_DONE;
 
-    if (!plugin) {
-        LERROR("Null plugin output pointer; failed to load plugin '%s'.\n", filepath);
-        return false;
+    u64 now  = AL_GetTime();
+    u64 wake = plugin->coroutine.wake_ns;
+    if (wake == AL_COROUTINE_PARKED) return AL_STEP_PARK;
+    if (wake <= now) return 0;
+
+    u64 wait_ms = (wake - now + AL_NS_PER_MS - 1) / AL_NS_PER_MS;
+    return wait_ms < AL_STEP_PARK ? (u32)wait_ms : AL_STEP_PARK - 1;
+}
+
+static void s_WakeProc(void* user_context) {
+    AL_Plugin* plugin = user_context;
+    AL_WakeTask(&plugin->task);
+}
+
+static const struct {
+    const char*      name;
+    enum PluginEntry entry;
+} s_entries[] = {
+    { "init", ENTRY_INIT },
+    { "update", ENTRY_UPDATE },
+    { "cleanup", ENTRY_CLEANUP },
+    { "proc", ENTRY_PROC },
+    { "save_state", ENTRY_SAVE_STATE },
+    { "restore_state", ENTRY_RESTORE_STATE },
+    { "step", ENTRY_STEP },
+};
+
+static u32 s_ExportedEntries(AL_DLL* dll) {
+    u32 entries = 0;
+    for (u32 i = 0; i < sizeof(s_entries) / sizeof(s_entries[0]); ++i) {
+        if (AL_LoadSymbol(dll, s_entries[i].name, false)) entries |= s_entries[i].entry;
     }
 
-    if (!AL_LoadDLL(filepath, &plugin->handle)) {
-        LERROR("Can't load plugin '%s'.", filepath);
+    return entries;
+}
+
+// dependencies are plugin filenames, relative to this plugin's directory
+static b8 s_AddDependency(const char* filepath, const char* name, AL_Plugin* plugin) {
+    const char* separator = strrchr(filepath, '/');
+    u64         prefix    = separator ? separator - filepath + 1 : 0;
+    u64         length    = strlen(name);
+
+    if (length == 0 || prefix + length > AL_MAX_PATH) {
+        LERROR("Invalid dependency '%s' of plugin '%s'.", name, filepath);
         return false;
     }
 
-    plugin->uuid    = *AL_Metadata(plugin->handle.filepath);
+    char path[AL_MAX_PATH + 1];
+    memcpy(path, filepath, prefix);
+    memcpy(path + prefix, name, length);
 
+    u64 uuid = FNV_1A_C(path, prefix + length);
+    AL_Append(plugin->dependencies, uuid);
+    return true;
+}
+
+// settings from the plugin's exports, once its DLL is loaded
+static b8 s_ReadExports(const char* filepath, AL_Plugin* plugin) {
     AL_Symbol* type = AL_LoadSymbol(&plugin->handle, "type", true);
     if (!type) {
         LERROR("Can't find required 'type' enum from plugin '%s'.", filepath);
@@ -37,15 +86,224 @@ b8         AL_LoadPlugin(const char* filepath, AL_Plugin* plugin) {
         plugin->type = *(enum PluginType*)type->addr;
     }
 
-    if (plugin->type & PLUGIN_ASYNC) {
+    // optional null-terminated list of plugin filenames
+    AL_Symbol* dependencies = AL_LoadSymbol(&plugin->handle, "dependencies", false);
+    if (dependencies) {
+        for (const char* const* name = dependencies->addr; *name; ++name) {
+            if (!s_AddDependency(filepath, *name, plugin)) return false;
+        }
+    }
+
+    AL_Symbol* phase    = AL_LoadSymbol(&plugin->handle, "phase", false);
+    AL_Symbol* priority = AL_LoadSymbol(&plugin->handle, "priority", false);
+    plugin->phase       = phase ? *(enum PluginPhase*)phase->addr : PHASE_UPDATE;
+    plugin->priority    = priority ? *(i32*)priority->addr : 0;
+
+    AL_Symbol* period    = AL_LoadSymbol(&plugin->handle, "period", false);
+    AL_Symbol* period_ms = AL_LoadSymbol(&plugin->handle, "period_ms", false);
+    plugin->period       = period ? *(u32*)period->addr : 0;
+    plugin->period_ms    = period_ms ? *(u32*)period_ms->addr : 0;
+
+    AL_Symbol* budget_us   = AL_LoadSymbol(&plugin->handle, "budget_us", false);
+    AL_Symbol* deadline_ms = AL_LoadSymbol(&plugin->handle, "deadline_ms", false);
+    plugin->budget_us      = budget_us ? *(u32*)budget_us->addr : 0;
+    plugin->deadline_ms    = deadline_ms ? *(u32*)deadline_ms->addr : 0;
+
+    plugin->entries        = s_ExportedEntries(&plugin->handle);
+    return true;
+}
+
+static b8 s_ReadDescribed(
+    const char* filepath, const AL_Descriptor* descriptor, AL_Plugin* plugin
+) {
+    plugin->type        = descriptor->type;
+    plugin->phase       = descriptor->phase;
+    plugin->priority    = descriptor->priority;
+    plugin->period      = descriptor->period;
+    plugin->period_ms   = descriptor->period_ms;
+    plugin->budget_us   = descriptor->budget_us;
+    plugin->deadline_ms = descriptor->deadline_ms;
+    plugin->entries     = descriptor->entries;
+
+    const char* names   = descriptor->dependencies;
+    for (const char* name = names; name < names + AL_DESCRIPTOR_NAMES && *name;) {
+        if (!s_AddDependency(filepath, name, plugin)) return false;
+        name += strlen(name) + 1;
+    }
+
+    return true;
+}
+
+// the descriptor embedded in 'source', if any, reported as 'filepath'; false if the file must
+// be rejected
+static b8 s_ReadDescriptorOf(
+    const char* source, const char* filepath, AL_Descriptor* descriptor, b8* described
+) {
+    u64 size   = sizeof(AL_Descriptor);
+    u64 read   = 0;
+    *described = false;
+
+    if (!AL_ReadSection(source, AL_DESCRIPTOR_SECTION, descriptor, size, &read)) return false;
+    if (read == 0) return true;
+
+    if (read < 2 * sizeof(u32) || descriptor->magic != AL_DESCRIPTOR_MAGIC) {
+        LERROR("Plugin '%s' has a malformed descriptor.", filepath);
+        return false;
+    }
+
+    if (descriptor->abi != AL_PLUGIN_ABI) {
+        LERROR(
+            "Plugin '%s' was built against plugin ABI %u, not %u; rejected.", filepath,
+            descriptor->abi, AL_PLUGIN_ABI
+        );
+        return false;
+    }
+
+    const char* names = descriptor->dependencies;
+    if (read != size || descriptor->size != size || names[AL_DESCRIPTOR_NAMES - 1] != '\0') {
+        LERROR("Plugin '%s' has a malformed descriptor.", filepath);
+        return false;
+    }
+
+    *described = true;
+    return true;
+}
+
+static b8 s_ReadDescriptor(const char* filepath, AL_Descriptor* descriptor, b8* described) {
+    return s_ReadDescriptorOf(filepath, filepath, descriptor, described);
+}
+
+typedef struct {
+    const char*   filepath;
+    AL_Descriptor descriptor;
+    b8            described;
+    b8            isolated; // the copy was refused because only a host may map it
+} PluginCopy;
+
+// declared PLUGIN_ISOLATED and not already in its host
+static b8 s_Isolated(const AL_Descriptor* descriptor) {
+    return descriptor && (descriptor->type & PLUGIN_ISOLATED) && !AL_InHost();
+}
+
+// the file may be rebuilt between reading its descriptor and copying it, so the descriptor
+// is read from the copy that gets loaded
+static b8 s_ReadCopyDescriptor(const char* copy_path, void* user_context) {
+    PluginCopy* copy = user_context;
+    if (!s_ReadDescriptorOf(copy_path, copy->filepath, &copy->descriptor, &copy->described))
+        return false;
+
+    copy->isolated = copy->described && s_Isolated(&copy->descriptor);
+    return !copy->isolated;
+}
+
+// everything but the entry points themselves, from the descriptor if there is one
+static b8 s_ReadMetadata(const char* filepath, const AL_Descriptor* descriptor, AL_Plugin* plugin) {
+    // registry key; cached as the filepath's hash metadata
+    plugin->uuid                          = FNV_1A_C(filepath, strlen(filepath));
+    *AL_Metadata(plugin->handle.filepath) = plugin->uuid;
+
+    plugin->dependencies                  = AL_Array(u64, 0);
+    plugin->sequence                      = 0;
+    plugin->stats                         = NULL;
+    plugin->used                          = 0;
+
+    b8 read = descriptor ? s_ReadDescribed(filepath, descriptor, plugin)
+                         : s_ReadExports(filepath, plugin);
+
+    if (read && (u32)plugin->phase >= PHASE_COUNT) {
+        LERROR("Invalid 'phase' %u of plugin '%s'.", plugin->phase, filepath);
+        read = false;
+    }
+
+    if (read && plugin->period && plugin->period_ms) {
+        LERROR("Plugin '%s' sets both 'period' and 'period_ms'.", filepath);
+        read = false;
+    }
+
+    if (!read) AL_Free(plugin->dependencies);
+    return read;
+}
+
+// the metadata AL_InspectPlugin reads; 'plugin->handle.filepath' must be set
+static void s_CopyMetadata(const AL_Plugin* from, AL_Plugin* plugin) {
+    plugin->uuid                          = from->uuid;
+    *AL_Metadata(plugin->handle.filepath) = from->uuid;
+
+    plugin->dependencies                  = AL_CloneArray(from->dependencies);
+    plugin->sequence                      = 0;
+    plugin->stats                         = NULL;
+    plugin->used                          = 0;
+    plugin->type                          = from->type;
+    plugin->phase                         = from->phase;
+    plugin->priority                      = from->priority;
+    plugin->period                        = from->period;
+    plugin->period_ms                     = from->period_ms;
+    plugin->budget_us                     = from->budget_us;
+    plugin->deadline_ms                   = from->deadline_ms;
+    plugin->entries                       = from->entries;
+}
+
+// resolves the plugin's entry points once its DLL is loaded and its metadata read; 'declared'
+// if its entry points weren't read from its exports
+static b8 s_BindPlugin(const char* filepath, b8 declared, AL_Plugin* plugin) {
+    u32 exported = declared ? s_ExportedEntries(&plugin->handle) : plugin->entries;
+    if (exported != plugin->entries) {
+        LERROR(
+            "Plugin '%s' declares entry points 0x%X but exports 0x%X.", filepath, plugin->entries,
+            exported
+        );
+        AL_Free(plugin->dependencies);
+        return false;
+    }
+
+    // its type was only known once its code had run here
+    if ((plugin->type & PLUGIN_ISOLATED) && !AL_InHost()) {
+        LERROR("Plugin '%s' must declare PLUGIN_ISOLATED with AL_DESCRIBE_PLUGIN.", filepath);
+        AL_Free(plugin->dependencies);
+        return false;
+    }
+
+    plugin->step = NULL;
+    plugin->task = (AL_Task){ 0 };
+
+    // it shares the manager's executor instead of owning a thread
+    if ((plugin->type & PLUGIN_ASYNC) && (plugin->entries & ENTRY_STEP)) {
+        AL_Symbol* step = AL_LoadSymbol(&plugin->handle, "step", true);
+        if (!step) {
+            LERROR("Can't find required 'step' function for asynchronous plugin '%s'.", filepath);
+            AL_Free(plugin->dependencies);
+            return false;
+        }
+
+        plugin->step = step->addr;
+    } else if (plugin->type & PLUGIN_ASYNC) {
         AL_Symbol* proc = AL_LoadSymbol(&plugin->handle, "proc", true);
         if (!proc) {
             LERROR("Can't find required 'proc' function for asynchronous plugin '%s'.", filepath);
+            AL_Free(plugin->dependencies);
             return false;
         }
 
-        if (!AL_CreateThread((PFN_thread_proc_t)proc->addr, plugin, false, &plugin->opt.thread)) {
+        PFN_thread_proc_t routine = (PFN_thread_proc_t)proc->addr;
+
+        // 'proc' runs unchanged, reading its sync flag from a thread that never starts
+        if (plugin->type & PLUGIN_COROUTINE) {
+            plugin->opt.thread = (AL_Thread){ .mutex        = AL_CreateMutex(),
+                                              .internals    = NULL,
+                                              .user_context = plugin };
+
+            if (!AL_CreateCoroutine(routine, plugin, &plugin->coroutine)) {
+                LERROR("Could not create coroutine for asynchronous plugin '%s'.", filepath);
+                AL_DestroyMutex(&plugin->opt.thread.mutex);
+                AL_Free(plugin->dependencies);
+                return false;
+            }
+
+            plugin->coroutine.on_wake = s_WakeProc;
+            plugin->step              = s_ResumeProc;
+        } else if (!AL_CreateThread(routine, plugin, false, &plugin->opt.thread)) {
             LERROR("Could not create thread process for asynchronous plugin '%s'.", filepath);
+            AL_Free(plugin->dependencies);
             return false;
         }
     } else {
@@ -65,10 +323,240 @@ b8         AL_LoadPlugin(const char* filepath, AL_Plugin* plugin) {
     else
         plugin->cleanup = NULL;
 
+    AL_Symbol* save_state    = AL_LoadSymbol(&plugin->handle, "save_state", false);
+    AL_Symbol* restore_state = AL_LoadSymbol(&plugin->handle, "restore_state", false);
+    plugin->save_state       = save_state ? save_state->addr : NULL;
+    plugin->restore_state    = restore_state ? restore_state->addr : NULL;
+    plugin->host             = NULL;
+
+    AL_TraceLabel(plugin->uuid, filepath);
+    return true;
+}
+
+// an isolated plugin is never mapped here, so none of its code, constructors included, runs in
+// this process; its host loads it and checks its exports against the descriptor
+static b8 s_BindIsolated(const char* filepath, AL_Plugin* plugin) {
+    // the host process serves init, update and exit calls only
+    if (plugin->type & PLUGIN_ASYNC) {
+        LERROR("Asynchronous plugin '%s' cannot be isolated.", filepath);
+        AL_Free(plugin->dependencies);
+        return false;
+    }
+
+    plugin->step          = NULL;
+    plugin->task          = (AL_Task){ 0 };
+    plugin->host          = NULL;
+    plugin->init          = AL_HostInit;
+    plugin->cleanup       = NULL;
+    plugin->save_state    = NULL;
+    plugin->restore_state = NULL;
+
+    if (!AL_CreateHost(filepath, &plugin->host)) {
+        AL_Free(plugin->dependencies);
+        return false;
+    }
+
+    plugin->opt.update = (plugin->entries & ENTRY_UPDATE) ? AL_HostUpdate(plugin->host) : NULL;
+
+    AL_TraceLabel(plugin->uuid, filepath);
+    return true;
+}
+
+// from its descriptor alone; 'descriptor' is null when 'inspected' holds its metadata instead
+static b8 s_LoadIsolated(
+    const char* filepath, const AL_Descriptor* descriptor, const AL_Plugin* inspected,
+    AL_Plugin* plugin
+) {
+    plugin->handle = (AL_DLL){ .loaded_symbols = NULL,
+                               .handle         = NULL,
+                               .filepath       = AL_CopyC(filepath, strlen(filepath)) };
+
+    b8 read        = true;
+    if (inspected) s_CopyMetadata(inspected, plugin);
+    else
+        read = s_ReadMetadata(filepath, descriptor, plugin);
+
+    if (!read || !s_BindIsolated(filepath, plugin)) {
+        AL_Free(plugin->handle.filepath);
+        plugin->handle.filepath = NULL;
+        return false;
+    }
+
+    LINFO("Plugin '%s' loaded in its host.", filepath);
+    return true;
+}
+
+b8 AL_LoadPlugin(const char* filepath, AL_Plugin* plugin) {
+    if (!filepath) {
+        LERROR("Invalid plugin filepath; loading failed.");
+        return false;
+    }
+
+    if (!plugin) {
+        LERROR("Null plugin output pointer; failed to load plugin '%s'.\n", filepath);
+        return false;
+    }
+
+    // an ABI mismatch is rejected before any of the plugin's code is mapped
+    AL_Descriptor descriptor;
+    b8            described;
+    if (!s_ReadDescriptor(filepath, &descriptor, &described)) {
+        LERROR("Can't load plugin '%s'.", filepath);
+        return false;
+    }
+
+    const AL_Descriptor* declared = described ? &descriptor : NULL;
+    if (s_Isolated(declared)) return s_LoadIsolated(filepath, declared, NULL, plugin);
+
+    if (!AL_LoadDLL(filepath, &plugin->handle)) {
+        LERROR("Can't load plugin '%s'.", filepath);
+        return false;
+    }
+
+    if (!s_ReadMetadata(filepath, declared, plugin) || !s_BindPlugin(filepath, described, plugin)) {
+        AL_UnloadDLL(&plugin->handle);
+        return false;
+    }
+
     LINFO("Plugin '%s' loaded.", filepath);
     return true;
 }
 
+b8 AL_LoadPluginCopy(const char* filepath, AL_Plugin* plugin) {
+    if (!filepath) {
+        LERROR("Invalid plugin filepath; loading failed.");
+        return false;
+    }
+
+    if (!plugin) {
+        LERROR("Null plugin output pointer; failed to load plugin '%s'.\n", filepath);
+        return false;
+    }
+
+    // a host maps the file in a process of its own, so an isolated plugin needs no copy
+    PluginCopy copy = { .filepath = filepath, .described = false, .isolated = false };
+    if (!AL_LoadDLLCopy(filepath, s_ReadCopyDescriptor, &copy, &plugin->handle)) {
+        if (copy.isolated) return s_LoadIsolated(filepath, &copy.descriptor, NULL, plugin);
+
+        LERROR("Can't load a copy of plugin '%s'.", filepath);
+        return false;
+    }
+
+    const AL_Descriptor* declared = copy.described ? &copy.descriptor : NULL;
+    if (!s_ReadMetadata(filepath, declared, plugin) ||
+        !s_BindPlugin(filepath, copy.described, plugin)) {
+        AL_UnloadDLL(&plugin->handle);
+        return false;
+    }
+
+    LINFO("Plugin '%s' loaded side by side.", filepath);
+    return true;
+}
+
+b8 AL_LoadInspectedPlugin(const AL_Plugin* inspected, b8 side_by_side, AL_Plugin* plugin) {
+    if (!inspected || !plugin) {
+        LERROR("Cannot load plugin from null metadata or into a null plugin.");
+        return false;
+    }
+
+    const char* filepath = inspected->handle.filepath;
+    if ((inspected->type & PLUGIN_ISOLATED) && !AL_InHost())
+        return s_LoadIsolated(filepath, NULL, inspected, plugin);
+
+    // the file may have changed since it was inspected, and the copy is what gets mapped, so
+    // its metadata is read from the copy like any other
+    if (side_by_side) return AL_LoadPluginCopy(filepath, plugin);
+
+    if (!AL_LoadDLL(filepath, &plugin->handle)) {
+        LERROR("Can't load plugin '%s'.", filepath);
+        return false;
+    }
+
+    s_CopyMetadata(inspected, plugin);
+    if (!s_BindPlugin(filepath, true, plugin)) {
+        AL_UnloadDLL(&plugin->handle);
+        return false;
+    }
+
+    LINFO("Plugin '%s' loaded from known metadata.", filepath);
+    return true;
+}
+
+b8 AL_InspectPlugin(const char* filepath, AL_Plugin* plugin) {
+    if (!filepath || !plugin) {
+        LERROR("Cannot inspect plugin with a null filepath or output pointer.");
+        return false;
+    }
+
+    AL_Descriptor descriptor;
+    b8            described;
+    if (!s_ReadDescriptor(filepath, &descriptor, &described)) return false;
+
+    memset(plugin, 0, sizeof(AL_Plugin));
+
+    // nothing but the file is needed
+    if (described) {
+        plugin->handle.filepath = AL_CopyC(filepath, strlen(filepath));
+        if (s_ReadMetadata(filepath, &descriptor, plugin)) return true;
+
+        AL_Free(plugin->handle.filepath);
+        return false;
+    }
+
+    if (!AL_LoadDLL(filepath, &plugin->handle)) {
+        LERROR("Can't inspect plugin '%s'.", filepath);
+        return false;
+    }
+
+    b8 read = s_ReadMetadata(filepath, NULL, plugin);
+    if (!AL_UnloadDLL(&plugin->handle)) LWARN("Inspected plugin '%s' stays mapped.", filepath);
+
+    plugin->handle.handle         = NULL;
+    plugin->handle.loaded_symbols = NULL;
+    if (!read) AL_Free(plugin->handle.filepath);
+    return read;
+}
+
+b8 AL_CopyPluginMetadata(const AL_Plugin* loaded, AL_Plugin* plugin) {
+    if (!loaded || !plugin) {
+        LERROR("Cannot copy plugin metadata from or into a null plugin.");
+        return false;
+    }
+
+    const char* filepath = loaded->handle.filepath;
+    memset(plugin, 0, sizeof(AL_Plugin));
+
+    plugin->handle.filepath = AL_CopyC(filepath, strlen(filepath));
+    s_CopyMetadata(loaded, plugin);
+    return true;
+}
+
+b8 AL_StopPlugin(AL_Plugin* plugin) {
+    if (!plugin || !(plugin->type & PLUGIN_ASYNC) || !plugin->step) return true;
+
+    if (!AL_CancelTask(&plugin->task, AL_PLUGIN_STOP_MS)) {
+        LERROR(
+            "Step of asynchronous plugin '%s' won't return; leaving it loaded.",
+            plugin->handle.filepath
+        );
+        return false;
+    }
+
+    // asked to exit like a thread would be, and resumed here until 'proc' returns
+    if (plugin->step == s_ResumeProc) {
+        AL_WriteSyncFlag(&plugin->opt.thread.mutex, SYNC_EXIT);
+        if (!AL_StopCoroutine(&plugin->coroutine, AL_PLUGIN_STOP_MS)) {
+            LERROR(
+                "Coroutine of asynchronous plugin '%s' won't stop; leaving it loaded.",
+                plugin->handle.filepath
+            );
+            return false;
+        }
+    }
+
+    return true;
+}
+
 b8 AL_UnloadPlugin(AL_Plugin* plugin) {
     if (!plugin) {
         LERROR("Cannot unload null plugin.");
@@ -77,25 +565,55 @@ b8 AL_UnloadPlugin(AL_Plugin* plugin) {
 
     assert(plugin->handle.filepath != NULL);
 
-    if (plugin->type & PLUGIN_ASYNC) {
-        if (!AL_DestroyThread(&plugin->opt.thread, AL_TIMEOUT_MAX)) {
+    // inspected only; nothing of it is loaded
+    if (!plugin->handle.handle && !plugin->host) {
+        AL_Free(plugin->dependencies);
+        AL_Free(plugin->handle.filepath);
+        plugin->dependencies    = NULL;
+        plugin->handle.filepath = NULL;
+        return true;
+    }
+
+    u64 begin = AL_TraceBegin();
+
+    if (!AL_StopPlugin(plugin)) return false;
+
+    if ((plugin->type & PLUGIN_ASYNC) && !plugin->step) {
+        if (!AL_DestroyThread(&plugin->opt.thread, AL_PLUGIN_STOP_MS)) {
             LERROR(
-                "Could not destroy thread of asynchronous plugin '%s'.", plugin->handle.filepath
+                "Thread of asynchronous plugin '%s' won't stop; leaving it loaded.",
+                plugin->handle.filepath
             );
             return false;
         }
     }
 
+    if ((plugin->type & PLUGIN_ASYNC) && plugin->step == s_ResumeProc) {
+        AL_DestroyCoroutine(&plugin->coroutine);
+        AL_DestroyMutex(&plugin->opt.thread.mutex);
+    }
+
+    // the host runs cleanup itself, if init got that far
+    if (plugin->host) {
+        AL_DestroyHost(plugin->host);
+        plugin->host = NULL;
+    }
+
     if (plugin->cleanup) {
         if (!plugin->cleanup())
             LWARN("Internal at-exit cleanup of plugin '%s' failed.", plugin->handle.filepath);
     }
 
-    if (!AL_UnloadDLL(&plugin->handle)) {
+    // an isolated plugin was only ever mapped by its host
+    if (plugin->handle.handle && !AL_UnloadDLL(&plugin->handle)) {
         LERROR("Plugin '%s' failed to unload.", plugin->handle.filepath);
         return false;
     }
 
+    AL_Free(plugin->dependencies);
+    plugin->dependencies = NULL;
+    AL_TraceEnd("unload", plugin->uuid, begin);
+
     LSUCCESS("Plugin '%s' (0x%X) succesfully unloaded.", plugin->handle.filepath, plugin->uuid);
     return true;
 }
@@ -111,9 +629,15 @@ void* AL_Get(AL_Plugin* plugin, const char* name, b8 required) {
         return NULL;
     }
 
-    assert(plugin->handle.loaded_symbols != NULL);
     assert(plugin->handle.filepath != NULL);
 
+    // its exports only exist in its host
+    if (!plugin->handle.handle) {
+        if (required)
+            LERROR("Isolated plugin '%s' exports nothing here.", plugin->handle.filepath);
+        return NULL;
+    }
+
     AL_Symbol* symbol = AL_LoadSymbol(&plugin->handle, name, required);
     if (symbol) return symbol->addr;
 
@@ -121,3 +645,26 @@ void* AL_Get(AL_Plugin* plugin, const char* name, b8 required) {
         LERROR("Symbol '%s' is not being exported by plugin '%s'.", name, plugin->handle.filepath);
     return NULL;
 }
+
+i64 AL_SendMessage(AL_Plugin* plugin, const void* data, u64 size, void* reply, u64 capacity) {
+    if (!plugin || (size && !data) || (capacity && !reply)) {
+        LERROR("Cannot send a message to a null plugin, or from or into a null buffer.");
+        return -1;
+    }
+
+    if (plugin->host) return AL_HostSend(plugin->host, data, size, reply, capacity);
+
+    if (!plugin->handle.handle) {
+        LERROR("Plugin '%s' is not loaded; cannot message it.", plugin->handle.filepath);
+        return -1;
+    }
+
+    PFN_plugin_message_t message = AL_Get(plugin, "message", false);
+    if (!message) {
+        LERROR("Plugin '%s' does not export 'message'.", plugin->handle.filepath);
+        return -1;
+    }
+
+    u64 replied = message(data, size, reply, capacity);
+    return replied < capacity ? replied : capacity;
+}
@@ -2,40 +2,181 @@
 #define AL_PLUGIN_H_
 
 #include "aldefs.h"
+#include "coroutine.h"
 #include "dll.h"
+#include "executor.h"
 #include "threads.h"
 
 enum PluginType {
-    PLUGIN_INVALID  = 0,
-    PLUGIN_OTHER    = 0x0001,
-    PLUGIN_KEYBOARD = 0x0010,
-    PLUGIN_ASYNC    = 0x0100,
+    PLUGIN_INVALID   = 0,
+    PLUGIN_OTHER     = 0x0001,
+    PLUGIN_KEYBOARD  = 0x0010,
+    PLUGIN_ASYNC     = 0x0100,
+    PLUGIN_PARALLEL  = 0x1000,   // update() may run concurrently with other parallel plugins
+    PLUGIN_ISOLATED  = 0x10000,  // runs in a child host process; a crash there spares the runtime
+    PLUGIN_COROUTINE = 0x100000, // async only: 'proc' runs on the executor, suspending as it blocks
+};
+
+// entry points a plugin exports, known before anything of it runs
+enum PluginEntry {
+    ENTRY_INIT          = 0x01,
+    ENTRY_UPDATE        = 0x02,
+    ENTRY_CLEANUP       = 0x04,
+    ENTRY_PROC          = 0x08,
+    ENTRY_SAVE_STATE    = 0x10,
+    ENTRY_RESTORE_STATE = 0x20,
+    ENTRY_STEP          = 0x40,
+};
+
+// sync updates run phase by phase each frame, so input is consumed in the frame it arrives
+enum PluginPhase {
+    PHASE_PRE_UPDATE = 0,
+    PHASE_UPDATE,
+    PHASE_POST_UPDATE,
+    PHASE_COUNT,
 };
 
 struct AL_PluginManager_;
 struct AL_Plugin_;
+struct AL_UpdateStats_;
+struct AL_Host_;
 
 typedef b8 (*PFN_plugin_init_t)(struct AL_PluginManager_*, struct AL_Plugin_*);
 typedef b8 (*PFN_plugin_cleanup_t)(void);
 typedef void (*PFN_plugin_update_t)(u64);
 
+// an async plugin exporting 'step' rather than 'proc' owns no thread: 'step' runs as a task on
+// the manager's executor, and returns how many milliseconds to wait before the next one,
+// AL_STEP_PARK or AL_STEP_DONE. it must not block for long; every async plugin shares the same
+// few workers.
+typedef u32 (*PFN_plugin_step_t)(struct AL_Plugin_*);
+
+#define AL_STEP_DONE AL_TIMEOUT_MAX
+
+// waits for a wake of the plugin's task rather than a time, as a coroutine blocked with no
+// timeout does; a plain step that returns it is never run again
+#define AL_STEP_PARK (AL_TIMEOUT_MAX - 1)
+
+// optional reload hand-off: the outgoing instance gives up a malloc'd block and the incoming
+// one takes ownership of it (even when it returns false). the block must not point into the
+// outgoing library's code or static data, which is unmapped afterwards.
+typedef b8 (*PFN_plugin_save_state_t)(void** state, u64* size);
+typedef b8 (*PFN_plugin_restore_state_t)(void* state, u64 size);
+
+// optional 'message' export, answering AL_SendMessage: reads 'size' bytes of 'data' and writes
+// at most 'capacity' bytes of reply, returning how many
+typedef u64 (*PFN_plugin_message_t)(const void* data, u64 size, void* reply, u64 capacity);
+
+// bumped whenever AL_Plugin, the manager the plugins see, or an entry point signature changes
+#define AL_PLUGIN_ABI         4
+
+#define AL_DESCRIPTOR_SECTION ".altair"
+#define AL_DESCRIPTOR_MAGIC   0x52494154 // "TAIR"
+#define AL_DESCRIPTOR_NAMES   512
+
+// embedded by AL_DESCRIBE_PLUGIN and read straight from the file, so a plugin is classified,
+// and rejected on an ABI mismatch, before dlopen runs any of its code. it replaces the
+// 'type', 'dependencies', 'phase', 'priority', 'period', 'period_ms', 'budget_us' and
+// 'deadline_ms' exports.
+typedef struct AL_Descriptor_ {
+    u32  magic;
+    u32  abi;  // AL_PLUGIN_ABI it was built against
+    u32  size; // of its AL_Descriptor
+    u32  type; // PluginType flags
+    u32  phase;
+    i32  priority;
+    u32  period;
+    u32  period_ms;
+    u32  budget_us;
+    u32  deadline_ms;
+    u32  entries;                           // PluginEntry flags; each must be exported
+    char dependencies[AL_DESCRIPTOR_NAMES]; // filenames, each null-terminated, then an empty one
+} AL_Descriptor;
+
+// at file scope in the plugin, e.g.
+//     AL_DESCRIBE_PLUGIN(.type = PLUGIN_OTHER, .entries = ENTRY_INIT | ENTRY_UPDATE,
+//                        .dependencies = "renderer.so\0");
+// fields left out keep the defaults of the exports they replace
+#if defined(AL_PLATFORM_UNIX)
+#    define AL_DESCRIBE_PLUGIN(...)                                                                \
+        __attribute__((section(AL_DESCRIPTOR_SECTION), used)) static const AL_Descriptor          \
+            al_descriptor_ = { .magic = AL_DESCRIPTOR_MAGIC,                                       \
+                               .abi   = AL_PLUGIN_ABI,                                             \
+                               .size  = sizeof(AL_Descriptor),                                     \
+                               .phase = PHASE_UPDATE,                                              \
+                               __VA_ARGS__ }
+#else
+#    define AL_DESCRIBE_PLUGIN(...) // plugins are classified through their exports
+#endif
+
 typedef struct AL_Plugin_ {
     union {
         AL_Thread           thread;
         PFN_plugin_update_t update;
     } opt;
 
-    AL_DLL               handle;
-    PFN_plugin_cleanup_t cleanup;
-    PFN_plugin_init_t    init;
-    u64                  uuid;
-    enum PluginType      type;
+    AL_DLL                     handle;
+    PFN_plugin_cleanup_t       cleanup;
+    PFN_plugin_init_t          init;
+    PFN_plugin_save_state_t    save_state;
+    PFN_plugin_restore_state_t restore_state;
+    PFN_plugin_step_t          step;         // async plugins without a thread only, else null
+    AL_Task                    task;         // runs 'step'; the manager submits it
+    AL_Coroutine               coroutine;    // PLUGIN_COROUTINE only; 'step' resumes it
+    u64*                       dependencies; // array of uuids, resolved from 'dependencies'
+    u64                        sequence;     // init order, reversed for teardown
+    u64                        uuid;
+    enum PluginType            type;
+    enum PluginPhase           phase;    // from 'phase', PHASE_UPDATE if not exported
+    i32                        priority; // from 'priority', lower runs first within a phase
+    u32                        period;      // from 'period', frames between updates; 0 every frame
+    u32                        period_ms;   // from 'period_ms', the same in milliseconds
+    u32                        budget_us;   // from 'budget_us', per update; 0 uses the manager's
+    u32                        deadline_ms; // from 'deadline_ms', before the watchdog flags a stall
+    u32                        entries;     // PluginEntry flags
+    u64                        used;        // atomic, last resolved; idles lazily registered ones
+    struct AL_UpdateStats_*    stats;       // owned by the manager
+    struct AL_Host_*           host;        // PLUGIN_ISOLATED only, else null
 } AL_Plugin;
 
+// how long unloading waits for an async plugin's thread or step before leaving it loaded
+#define AL_PLUGIN_STOP_MS 2000
+
 b8    AL_LoadPlugin(const char* filepath, AL_Plugin* plugin);
 
+// loads from a private copy of the file, side by side with an already loaded instance
+b8    AL_LoadPluginCopy(const char* filepath, AL_Plugin* plugin);
+
+// reads a plugin's metadata without keeping it loaded, from its descriptor if it has one and
+// through a dlopen if not: only its uuid, type, dependencies, 'entries' and settings are
+// filled in, and 'handle.handle' stays null. nothing but AL_UnloadPlugin may be called on it.
+b8    AL_InspectPlugin(const char* filepath, AL_Plugin* plugin);
+
+// loads the plugin 'inspected' describes with that metadata, rather than reading its descriptor
+// or exports again; its entry points are still checked against its exports. side by side, the
+// copy is made after the inspection, so its own metadata is read as AL_LoadPluginCopy does
+b8    AL_LoadInspectedPlugin(const AL_Plugin* inspected, b8 side_by_side, AL_Plugin* plugin);
+
+// fills 'plugin' as AL_InspectPlugin would, from a loaded one
+b8    AL_CopyPluginMetadata(const AL_Plugin* loaded, AL_Plugin* plugin);
+
+// stops an async plugin's step, running a coroutine's 'proc' to its end on the calling thread,
+// so it must be called without any lock 'proc' may take; a thread is left to AL_UnloadPlugin.
+// false if the step won't stop.
+b8    AL_StopPlugin(AL_Plugin* plugin);
+
+// stops whatever AL_StopPlugin didn't. fails, leaving the library loaded, if an async plugin's
+// thread or step won't stop; the plugin must then be leaked, since it may still be in use
 b8    AL_UnloadPlugin(AL_Plugin* plugin);
 
 void* AL_Get(AL_Plugin* plugin, const char* symbol, b8 required);
 
+// calls the plugin's 'message' export with 'size' bytes and copies its reply into 'reply'. for
+// an isolated plugin both go through its host's shared memory, so the message may be at most
+// AL_HOST_PAYLOAD_MAX bytes and the reply is cut there. returns the reply's size, or -1 if the
+// plugin has no 'message' or could not be called.
+ALAPI i64 AL_SendMessage(
+    AL_Plugin* plugin, const void* data, u64 size, void* reply, u64 capacity
+);
+
 #endif
@@ -0,0 +1,83 @@
+#ifndef AL_PLUGINCACHE_H_
+#define AL_PLUGINCACHE_H_
+
+#include "aldefs.h"
+#include "hashmap.h"
+#include "plugin.h"
+#include "string.h"
+#include "threads.h"
+
+#define AL_PLUGIN_CACHE_MAGIC        0x48434C41 // "ALCH"
+#define AL_PLUGIN_CACHE_DEPENDENCIES 16 // plugins with more are never cached
+
+// what a plugin file is known by; any change to it, short of identical contents, misses
+typedef struct AL_CacheKey_ {
+    u64 device;
+    u64 inode;
+    u64 size;
+    u64 mtime_ns;
+} AL_CacheKey;
+
+// a plugin's validated metadata, as AL_InspectPlugin reads it
+typedef struct AL_CacheRecord_ {
+    u64         uuid; // 0 for an empty record
+    AL_CacheKey key;
+    u64         content; // FNV-1a of the file
+    u32         type;
+    u32         phase;
+    i32         priority;
+    u32         period;
+    u32         period_ms;
+    u32         budget_us;
+    u32         deadline_ms;
+    u32         entries;
+    u32         dependency_count;
+    u32         padding;
+    u64         dependencies[AL_PLUGIN_CACHE_DEPENDENCIES];
+} AL_CacheRecord;
+
+// the file: this header, then 'capacity' records, open-addressed by uuid with linear probing,
+// so a lookup reads the mapping in place
+typedef struct AL_CacheHeader_ {
+    u32 magic;
+    u32 abi;         // AL_PLUGIN_ABI it was written by; any other discards the file
+    u32 record_size; // of its AL_CacheRecord
+    u32 capacity;    // power of two
+} AL_CacheHeader;
+
+// the file stays mapped read-only while the records looked up or stored since it was opened
+// collect in memory. closing writes only those out to a fresh file, renamed over the old one,
+// so records of plugins that were removed, renamed or just not loaded any more are dropped.
+typedef struct AL_PluginCache_ {
+    AL_Mutex        mutex;
+    AL_String       filepath; // null while closed
+    const u8*       mapping;  // null if there was no usable file
+    u64             length;
+    u64             mapped;  // records in the file
+    AL_CacheRecord* used;    // array, hit or stored since opening
+    AL_HashMap      index;   // uuid -> index into 'used'
+    b8              changed; // a record was stored or rekeyed, so the file is out of date
+    u64             hits;    // atomic
+    u64             misses;  // atomic
+} AL_PluginCache;
+
+// a missing or unusable file opens an empty cache
+b8   AL_OpenPluginCache(const char* filepath, AL_PluginCache* cache);
+
+// writes the cache back if anything was stored or a record went unused; false if that failed
+b8   AL_ClosePluginCache(AL_PluginCache* cache);
+
+b8   AL_StatPlugin(const char* filepath, AL_CacheKey* key);
+
+// fills 'plugin' as AL_InspectPlugin would if the file 'key' was taken from still matches the
+// record of 'filepath'. a record whose key went stale still matches if the contents hash the
+// same, and is stored again under the new key.
+b8   AL_LookupPluginCache(
+    AL_PluginCache* cache, const char* filepath, const AL_CacheKey* key, AL_Plugin* plugin
+);
+
+// records the metadata of an inspected or loaded plugin, read from the file 'key' was taken
+// from before it was read; nothing is stored if the file has changed since
+void AL_StorePluginCache(AL_PluginCache* cache, const AL_CacheKey* key, const AL_Plugin* plugin);
+
+#endif
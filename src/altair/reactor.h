@@ -0,0 +1,41 @@
+#ifndef AL_REACTOR_H_
+#define AL_REACTOR_H_
+
+#include "aldefs.h"
+#include "threads.h"
+
+// file descriptors ready in one wake-up of the loop, at most
+#define AL_REACTOR_BATCH 64
+
+enum ReactorEvent {
+    REACTOR_READ   = 0x1,
+    REACTOR_WRITE  = 0x2,
+    REACTOR_CLOSED = 0x4, // hung up or failed; handed out whether asked for or not
+    REACTOR_ONCE   = 0x8, // called once, then disarmed until the descriptor is unwatched
+};
+
+// called on the reactor's thread, again and again for as long as the descriptor stays ready
+typedef void (*PFN_reactor_callback_t)(i32 fd, u32 events, void* user_context);
+
+// one thread sleeping on every watched descriptor at once, with no timeout: it wakes only
+// when one of them is ready, or when the reactor is destroyed
+typedef struct AL_Reactor_ {
+    AL_Thread thread;
+    void*     internals; // implementation defined
+} AL_Reactor;
+
+ALAPI b8 AL_CreateReactor(AL_Reactor* reactor);
+
+// stops the loop, waiting out the callback in flight; descriptors still watched are not closed
+ALAPI b8 AL_DestroyReactor(AL_Reactor* reactor);
+
+// 'events' are ReactorEvent flags; one watch per descriptor
+ALAPI b8 AL_WatchFd(
+    AL_Reactor* reactor, i32 fd, u32 events, PFN_reactor_callback_t callback, void* user_context
+);
+
+// once it returns, the callback is neither running nor called again, so its code may be
+// unloaded. may be called from inside a callback, its own included.
+ALAPI b8 AL_UnwatchFd(AL_Reactor* reactor, i32 fd);
+
+#endif
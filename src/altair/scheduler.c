@@ -0,0 +1,96 @@
+#include "scheduler.h"
+
+#include <math.h>
+
+#include "aldefs.h"
+#include "clock.h"
+#include "log.h"
+
+// sleeps through most of the wait, then spins through the tail the kernel can't hit exactly
+static void s_WaitUntil(u64 deadline, u64 spin) {
+    if (deadline > spin) AL_SleepUntil(deadline - spin);
+    while (AL_GetTime() < deadline);
+}
+
+static void s_RecordInterval(AL_Scheduler* scheduler, u64 interval) {
+    scheduler->frames += 1;
+    if (interval < scheduler->min) scheduler->min = interval;
+    if (interval > scheduler->max) scheduler->max = interval;
+
+    f64 delta        = (f64)interval - scheduler->mean;
+    scheduler->mean += delta / scheduler->frames;
+    scheduler->m2   += delta * ((f64)interval - scheduler->mean);
+}
+
+b8 AL_CreateScheduler(u32 tick_rate, b8 fixed_step, AL_Scheduler* scheduler) {
+    if (!scheduler) {
+        LERROR("Cannot create a null scheduler.");
+        return false;
+    }
+
+    scheduler->period     = tick_rate ? AL_NS_PER_S / tick_rate : 0;
+    scheduler->spin       = AL_SCHEDULER_SPIN_NS;
+    scheduler->fixed_step = fixed_step;
+
+    scheduler->frame      = 0;
+    scheduler->delta      = scheduler->period;
+    scheduler->start      = AL_GetTime();
+    scheduler->deadline   = scheduler->start;
+
+    AL_ResetFrameStats(scheduler);
+    return true;
+}
+
+u64 AL_WaitFrame(AL_Scheduler* scheduler) {
+    u64 now = AL_GetTime();
+
+    if (scheduler->period && scheduler->frame > 0) {
+        if (now > scheduler->start + scheduler->period) scheduler->overruns += 1;
+        if (now < scheduler->deadline) s_WaitUntil(scheduler->deadline, scheduler->spin);
+    }
+
+    u64 start = AL_GetTime();
+    if (scheduler->frame > 0) s_RecordInterval(scheduler, start - scheduler->start);
+
+    scheduler->delta = scheduler->fixed_step ? scheduler->period : start - scheduler->start;
+    scheduler->start = start;
+
+    if (!scheduler->fixed_step) {
+        scheduler->deadline = start + scheduler->period;
+    } else {
+        // late fixed step frames run back to back until caught up, within a bounded backlog
+        scheduler->deadline += scheduler->period;
+
+        u64 backlog = AL_SCHEDULER_MAX_BACKLOG * scheduler->period;
+        if (start > scheduler->deadline + backlog) {
+            scheduler->dropped += (start - scheduler->deadline) / scheduler->period;
+            scheduler->deadline = start + scheduler->period;
+        }
+    }
+
+    return scheduler->frame++;
+}
+
+void AL_GetFrameStats(const AL_Scheduler* scheduler, AL_FrameStats* stats) {
+    if (!scheduler || !stats) return;
+
+    stats->frames    = scheduler->frames;
+    stats->overruns  = scheduler->overruns;
+    stats->dropped   = scheduler->dropped;
+    stats->min_ns    = scheduler->frames ? scheduler->min : 0;
+    stats->max_ns    = scheduler->max;
+    stats->mean_ns   = scheduler->mean;
+    stats->jitter_ns = scheduler->frames > 1 ? sqrt(scheduler->m2 / (scheduler->frames - 1)) : 0;
+}
+
+void AL_ResetFrameStats(AL_Scheduler* scheduler) {
+    if (!scheduler) return;
+
+    scheduler->frames   = 0;
+    scheduler->overruns = 0;
+    scheduler->dropped  = 0;
+    scheduler->min      = (u64)-1;
+    scheduler->max      = 0;
+    scheduler->mean     = 0;
+    scheduler->m2       = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef AL_SCHEDULER_H_
+#define AL_SCHEDULER_H_
+
+#include "aldefs.h"
+#include "clock.h"
+
+// default tail of each wait spent spinning instead of sleeping, to absorb wake-up latency
+#define AL_SCHEDULER_SPIN_NS     (200 * AL_NS_PER_US)
+
+// a fixed step scheduler catches up at most this many late frames before dropping the rest
+#define AL_SCHEDULER_MAX_BACKLOG 8
+
+typedef struct AL_FrameStats_ {
+    u64 frames;    // intervals measured
+    u64 overruns;  // frames whose work outlasted the period
+    u64 dropped;   // fixed step frames given up on after falling too far behind
+    u64 min_ns;    // frame start to frame start
+    u64 max_ns;
+    f64 mean_ns;
+    f64 jitter_ns; // standard deviation of the interval
+} AL_FrameStats;
+
+// paces a frame loop. a fixed step keeps deadlines on a strict grid and reports the
+// period as the timestep; a variable step schedules from each frame's start and reports
+// the measured interval.
+typedef struct AL_Scheduler_ {
+    u64 period;   // ns, 0 runs unpaced
+    u64 spin;     // ns; 0 always sleeps, >= period always spins
+    b8  fixed_step;
+
+    u64 frame;    // index of the next frame
+    u64 delta;    // ns timestep of the current frame
+    u64 start;    // start of the current frame
+    u64 deadline; // start of the next frame
+
+    // interval statistics, running (Welford)
+    u64 frames, overruns, dropped, min, max;
+    f64 mean, m2;
+} AL_Scheduler;
+
+// a zero tick rate runs unpaced
+ALAPI b8   AL_CreateScheduler(u32 tick_rate, b8 fixed_step, AL_Scheduler* scheduler);
+
+// waits for the next tick, returns its frame index
+ALAPI u64  AL_WaitFrame(AL_Scheduler* scheduler);
+
+ALAPI void AL_GetFrameStats(const AL_Scheduler* scheduler, AL_FrameStats* stats);
+
+ALAPI void AL_ResetFrameStats(AL_Scheduler* scheduler);
+
+#endif
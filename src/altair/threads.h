@@ -10,11 +10,16 @@ enum SyncFlag {
     SYNC_EXIT,
     SYNC_WAIT,
     SYNC_START,
+    SYNC_PING, // the watchdog asking the reader to check in; reads and awaits as unset
 };
 
+// the flag is a futex word: reading it is a relaxed load, and a write only makes a syscall
+// when a thread is asleep on it
 typedef struct AL_Mutex_ {
-    void*         internals; // implementation defined
-    enum SyncFlag flag;
+    void* internals; // implementation defined
+    u32   flag;      // atomic, enum SyncFlag
+    u32   waiters;   // atomic, threads asleep on 'flag'
+    u64   heartbeat; // atomic, when the reader last claimed a set flag, coarsely; 0 if never
 } AL_Mutex;
 
 ALAPI AL_Mutex AL_CreateMutex(void);
@@ -35,11 +40,20 @@ ALAPI void     AL_WakeCondition(AL_Mutex* mutex);
         statement AL_Unlock(pmutex);                                                               \
     } while (0)
 
+// wakes every thread asleep on the flag; needs no lock
 ALAPI void AL_WriteSyncFlag(AL_Mutex* mutex, enum SyncFlag flag);
 
-// resets the flag after reading
+// resets the flag after reading; needs no lock. an unset flag costs one relaxed load, so the
+// heartbeat is only stamped when a set flag, a ping included, is claimed
 ALAPI enum SyncFlag AL_ReadSyncFlag(AL_Mutex* mutex);
 
+// sets the flag to SYNC_PING if it is unset, without waking anyone; false if it was still set,
+// so the reader has not read it since the last ping
+ALAPI b8 AL_PingSyncFlag(AL_Mutex* mutex);
+
+// sleeps until the flag is set, leaving it set; false on timeout
+ALAPI b8 AL_AwaitSyncFlag(AL_Mutex* mutex, u32 timeout_ms);
+
 #define AL_AsyncWhile(pmutex, flag) while (AL_ReadSyncFlag(pmutex) != (flag))
 
 typedef struct AL_Thread_ {
@@ -54,10 +68,19 @@ b8 AL_CreateThread(
     PFN_thread_proc_t routine, void* user_context, b8 launch_immediately, AL_Thread* thread
 );
 
+// asks the thread to exit and waits for it; if it doesn't within 'timeout_ms' it is left
+// running, and the thread and its context must not be freed
 b8        AL_DestroyThread(AL_Thread* thread, u32 timeout_ms);
 
 void      AL_StartThread(AL_Thread* thread);
 
 ALAPI u64 AL_GetPid(const AL_Thread* thread);
 
+// gives up the rest of the calling thread's timeslice, or suspends the calling coroutine
+ALAPI void AL_Yield(void);
+
+ALAPI u32  AL_GetCoreCount(void);
+
+typedef void (*PFN_parallel_proc_t)(u64 index, void* user_context);
+
 #endif
@@ -0,0 +1,110 @@
+#include "timingwheel.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "aldefs.h"
+
+static AL_Timer** s_SlotOf(AL_TimingWheel* wheel, u64 due) {
+    u64 delta = due > wheel->now ? due - wheel->now : 0;
+    u32 level = 0;
+
+    while (level + 1 < AL_WHEEL_LEVELS && delta >= (1ull << (AL_WHEEL_BITS * (level + 1))))
+        level += 1;
+
+    // past the top level's span; parked where it cascades back down in time
+    if (delta >= (1ull << (AL_WHEEL_BITS * AL_WHEEL_LEVELS)))
+        due = wheel->now + (1ull << (AL_WHEEL_BITS * AL_WHEEL_LEVELS)) - 1;
+
+    return &wheel->slots[level][(due >> (AL_WHEEL_BITS * level)) & (AL_WHEEL_SLOTS - 1)];
+}
+
+static void s_Link(AL_Timer** slot, AL_Timer* timer) {
+    timer->prev = NULL;
+    timer->next = *slot;
+    timer->slot = slot;
+    if (*slot) (*slot)->prev = timer;
+    *slot = timer;
+}
+
+static AL_Timer* s_Take(AL_Timer** slot) {
+    AL_Timer* timers = *slot;
+    *slot            = NULL;
+    return timers;
+}
+
+void AL_CreateTimingWheel(u64 now, AL_TimingWheel* wheel) {
+    assert(wheel != NULL);
+
+    memset(wheel, 0, sizeof(AL_TimingWheel));
+    wheel->now = now;
+}
+
+void AL_ScheduleTimer(AL_TimingWheel* wheel, AL_Timer* timer, u64 due) {
+    assert(wheel != NULL && timer != NULL);
+
+    timer->due = due > wheel->now ? due : wheel->now + 1;
+    s_Link(s_SlotOf(wheel, timer->due), timer);
+    wheel->count += 1;
+}
+
+void AL_CancelTimer(AL_TimingWheel* wheel, AL_Timer* timer) {
+    assert(wheel != NULL && timer != NULL);
+
+    if (timer->prev) timer->prev->next = timer->next;
+    else
+        *timer->slot = timer->next;
+
+    if (timer->next) timer->next->prev = timer->prev;
+
+    timer->next = timer->prev = NULL;
+    wheel->count -= 1;
+}
+
+AL_Timer* AL_AdvanceTimingWheel(AL_TimingWheel* wheel, u64 tick) {
+    assert(wheel != NULL);
+    AL_Timer* expired = NULL;
+
+    while (wheel->now < tick && wheel->count > 0) {
+        wheel->now += 1;
+
+        // entering a new span on a level pulls that slot's timers down, top level first so
+        // nothing lands in a lower slot that was already pulled this tick
+        u32 levels = 1;
+        while (levels < AL_WHEEL_LEVELS &&
+               (wheel->now & ((1ull << (AL_WHEEL_BITS * levels)) - 1)) == 0)
+            levels += 1;
+
+        for (u32 level = levels - 1; level > 0; --level) {
+            u64       index  = (wheel->now >> (AL_WHEEL_BITS * level)) & (AL_WHEEL_SLOTS - 1);
+            AL_Timer* timers = s_Take(&wheel->slots[level][index]);
+
+            while (timers) {
+                AL_Timer* timer = timers;
+                timers          = timer->next;
+                s_Link(s_SlotOf(wheel, timer->due), timer);
+            }
+        }
+
+        AL_Timer* timers = s_Take(&wheel->slots[0][wheel->now & (AL_WHEEL_SLOTS - 1)]);
+        while (timers) {
+            AL_Timer* timer = timers;
+            timers          = timer->next;
+
+            // a parked timer lands here early, a full top-level span before it is due
+            if (timer->due > wheel->now) {
+                s_Link(s_SlotOf(wheel, timer->due), timer);
+                continue;
+            }
+
+            timer->prev   = NULL;
+            timer->next   = expired;
+            expired       = timer;
+            wheel->count -= 1;
+        }
+    }
+
+    // nothing left to expire; skip the idle ticks
+    if (wheel->now < tick) wheel->now = tick;
+    return expired;
+}
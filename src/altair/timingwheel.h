@@ -0,0 +1,38 @@
+#ifndef AL_TIMINGWHEEL_H_
+#define AL_TIMINGWHEEL_H_
+
+#include "aldefs.h"
+
+#define AL_WHEEL_BITS   6
+#define AL_WHEEL_SLOTS  (1 << AL_WHEEL_BITS)
+#define AL_WHEEL_LEVELS 4 // spans 2^24 ticks; timers further out are parked on the top level
+
+// intrusive; embed it in whatever is being scheduled
+typedef struct AL_Timer_ {
+    struct AL_Timer_*  next;
+    struct AL_Timer_*  prev;
+    struct AL_Timer_** slot; // list head it is linked into
+    u64                due;  // tick
+} AL_Timer;
+
+// hierarchical timing wheel: each level's slots span AL_WHEEL_SLOTS of the level below, and a
+// slot's timers cascade down a level when the wheel reaches it. scheduling, cancelling and
+// expiring are O(1); advancing costs one slot visit per tick.
+typedef struct AL_TimingWheel_ {
+    u64       now; // current tick
+    u64       count;
+    AL_Timer* slots[AL_WHEEL_LEVELS][AL_WHEEL_SLOTS];
+} AL_TimingWheel;
+
+void      AL_CreateTimingWheel(u64 now, AL_TimingWheel* wheel);
+
+// timers due at or before the current tick expire on the next advance
+void      AL_ScheduleTimer(AL_TimingWheel* wheel, AL_Timer* timer, u64 due);
+
+void      AL_CancelTimer(AL_TimingWheel* wheel, AL_Timer* timer);
+
+// moves the wheel forward to 'tick' and returns every timer that expired on the way, as a
+// null-terminated list linked through 'next'
+AL_Timer* AL_AdvanceTimingWheel(AL_TimingWheel* wheel, u64 tick);
+
+#endif
@@ -0,0 +1,258 @@
+#include "trace.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "aldefs.h"
+#include "atomic.h"
+#include "clock.h"
+#include "hashmap.h"
+#include "log.h"
+#include "string.h"
+#include "threads.h"
+
+#define AL_TRACE_MASK (AL_TRACE_RING_EVENTS - 1)
+
+typedef struct {
+    FILE*          file;
+    AL_TraceEvent* scratch; // flusher's copy of a ring
+    AL_HashMap     labels;  // id -> AL_String
+    u64            origin;  // trace timestamps are relative to it
+    u64            written;
+    u64            dropped;
+} TraceSession;
+
+static AL_TraceRing                  s_rings[AL_TRACE_MAX_THREADS];
+static TraceSession                  s_session;
+static b8                            s_enabled; // atomic
+static u32                           s_lock;    // atomic, guards the session
+
+static AL_THREAD_LOCAL AL_TraceRing* s_ring = NULL;
+
+// held for load-time labelling and flushing only, never on the recording path
+static void                          s_Lock(void) {
+    u32 expected = 0;
+    while (!AL_AtomicCompareExchange(&s_lock, &expected, 1, AL_ACQUIRE)) {
+        expected = 0;
+        AL_Yield();
+    }
+}
+
+static void s_Unlock(void) { AL_AtomicStore(&s_lock, 0, AL_RELEASE); }
+
+static AL_TraceRing* s_ClaimRing(void) {
+    for (u32 i = 0; i < AL_TRACE_MAX_THREADS; ++i) {
+        AL_TraceRing* ring     = s_rings + i;
+        u64           expected = false;
+        if (!AL_AtomicCompareExchange(&ring->claimed, &expected, true, AL_ACQ_REL)) continue;
+
+        // rings are kept for the life of the process, so a late span never writes freed memory
+        if (!ring->events) {
+            AL_TraceEvent* events = malloc(AL_TRACE_RING_EVENTS * sizeof(AL_TraceEvent));
+            if (!events) {
+                AL_AtomicStore(&ring->claimed, false, AL_RELEASE);
+                return NULL;
+            }
+
+            AL_AtomicStore(&ring->events, events, AL_RELEASE);
+        }
+
+        s_ring = ring;
+        return ring;
+    }
+
+    return NULL;
+}
+
+static void s_WriteString(FILE* file, const char* string) {
+    for (; *string; ++string) {
+        if (*string == '"' || *string == '\\') fputc('\\', file);
+        if ((u8)*string >= 0x20) fputc(*string, file);
+    }
+}
+
+static void s_WriteEvent(const AL_TraceEvent* event, u32 thread) {
+    TraceSession* session = &s_session;
+    u64           origin  = session->origin;
+    u64           begin   = event->begin_ns > origin ? event->begin_ns - origin : 0;
+    u64           length  = event->end_ns > event->begin_ns ? event->end_ns - event->begin_ns : 0;
+
+    fprintf(
+        session->file,
+        "%s\n{\"name\":\"%s\",\"cat\":\"altair\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+        "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":\"0x%016llx\"",
+        session->written ? "," : "", event->name, thread, (f64)begin / AL_NS_PER_US,
+        (f64)length / AL_NS_PER_US, event->id
+    );
+
+    u64 label;
+    if (AL_HashMapFind(&session->labels, event->id, &label)) {
+        fputs(",\"label\":\"", session->file);
+        s_WriteString(session->file, (const char*)label);
+        fputc('"', session->file);
+    }
+
+    fputs("}}", session->file);
+    session->written += 1;
+}
+
+// copies a ring out, then drops whatever its writer may have lapped while it was being read
+static void s_DrainRing(AL_TraceRing* ring, u32 thread) {
+    TraceSession*  session = &s_session;
+    AL_TraceEvent* events  = AL_AtomicLoad(&ring->events, AL_ACQUIRE);
+    if (!events) return;
+
+    u64 head = AL_AtomicLoad(&ring->head, AL_ACQUIRE);
+    u64 from = ring->tail;
+    if (head - from > AL_TRACE_RING_EVENTS) from = head - AL_TRACE_RING_EVENTS;
+
+    for (u64 i = from; i < head; ++i) session->scratch[i - from] = events[i & AL_TRACE_MASK];
+
+    // one more event may be mid-write on top of the oldest one copied
+    AL_AtomicFence(AL_ACQUIRE);
+    u64 lapped = AL_AtomicLoad(&ring->head, AL_RELAXED) + 1;
+    u64 valid  = lapped > AL_TRACE_RING_EVENTS ? lapped - AL_TRACE_RING_EVENTS : 0;
+    if (valid < from) valid = from;
+
+    for (u64 i = valid; i < head; ++i) s_WriteEvent(session->scratch + i - from, thread);
+
+    session->dropped += (valid < head ? valid : head) - ring->tail;
+    ring->tail        = head;
+}
+
+b8 AL_StartTrace(const char* filepath) {
+    if (!filepath) {
+        LERROR("Cannot trace into a null filepath.");
+        return false;
+    }
+
+    if (AL_IsTracing()) {
+        LERROR("A trace is already being recorded; cannot start '%s'.", filepath);
+        return false;
+    }
+
+    TraceSession* session = &s_session;
+    b8            started = false;
+
+    s_Lock();
+
+    session->file    = fopen(filepath, "w");
+    session->scratch = malloc(AL_TRACE_RING_EVENTS * sizeof(AL_TraceEvent));
+
+    if (session->file && session->scratch && AL_CreateHashMap(0, &session->labels)) {
+        session->origin  = AL_GetTime();
+        session->written = 0;
+        session->dropped = 0;
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", session->file);
+
+        // leftovers of an earlier trace
+        for (u32 i = 0; i < AL_TRACE_MAX_THREADS; ++i)
+            s_rings[i].tail = AL_AtomicLoad(&s_rings[i].head, AL_ACQUIRE);
+
+        AL_AtomicStore(&s_enabled, true, AL_RELEASE);
+        started = true;
+    } else {
+        if (session->file) fclose(session->file);
+        free(session->scratch);
+    }
+
+    s_Unlock();
+
+    if (!started) {
+        LERROR("Could not start trace '%s'.", filepath);
+        return false;
+    }
+
+    LINFO("Tracing into '%s'.", filepath);
+    return true;
+}
+
+b8 AL_FlushTrace(void) {
+    s_Lock();
+
+    b8 flushed = s_session.file != NULL;
+    if (flushed) {
+        for (u32 i = 0; i < AL_TRACE_MAX_THREADS; ++i) s_DrainRing(s_rings + i, i + 1);
+        fflush(s_session.file);
+    }
+
+    s_Unlock();
+    return flushed;
+}
+
+b8 AL_StopTrace(void) {
+    if (!AL_IsTracing()) {
+        LERROR("No trace is being recorded; cannot stop it.");
+        return false;
+    }
+
+    AL_AtomicStore(&s_enabled, false, AL_RELEASE);
+    AL_FlushTrace();
+
+    TraceSession* session = &s_session;
+    s_Lock();
+
+    fputs("\n]}\n", session->file);
+    b8 closed = fclose(session->file) == 0;
+
+    for (u64 i = 0; i < session->labels.capacity; ++i) {
+        AL_HashEntry* entry = session->labels.entries + i;
+        if (entry->key != AL_HASHMAP_EMPTY_KEY) AL_Free((AL_String)entry->value);
+    }
+
+    AL_DestroyHashMap(&session->labels);
+    free(session->scratch);
+    session->file    = NULL;
+    session->scratch = NULL;
+
+    u64 written      = session->written;
+    u64 dropped      = session->dropped;
+    s_Unlock();
+
+    if (dropped) LWARN("Trace dropped %llu spans; flush it more often.", dropped);
+    if (!closed) {
+        LERROR("Could not write trace file.");
+        return false;
+    }
+
+    LSUCCESS("Trace of %llu spans written.", written);
+    return true;
+}
+
+b8  AL_IsTracing(void) { return AL_AtomicLoad(&s_enabled, AL_RELAXED); }
+
+u64 AL_TraceBegin(void) { return AL_AtomicLoad(&s_enabled, AL_RELAXED) ? AL_GetTime() : 0; }
+
+void AL_TraceEnd(const char* name, u64 id, u64 begin) {
+    if (begin) AL_TraceSpan(name, id, begin, AL_GetTime());
+}
+
+void AL_TraceSpan(const char* name, u64 id, u64 begin, u64 end) {
+    AL_TraceRing* ring = s_ring ? s_ring : s_ClaimRing();
+    if (!ring) return;
+
+    u64 head                           = ring->head;
+    ring->events[head & AL_TRACE_MASK] = (AL_TraceEvent){
+        .name = name, .id = id, .begin_ns = begin, .end_ns = end
+    };
+    AL_AtomicStore(&ring->head, head + 1, AL_RELEASE);
+}
+
+void AL_TraceLabel(u64 id, const char* label) {
+    if (!label || !AL_IsTracing()) return;
+
+    s_Lock();
+    if (s_session.file && !AL_HashMapFind(&s_session.labels, id, NULL)) {
+        AL_String copy = AL_CopyC(label, strlen(label));
+        if (!AL_HashMapInsert(&s_session.labels, id, (u64)copy)) AL_Free(copy);
+    }
+    s_Unlock();
+}
+
+void AL_ReleaseTraceRing(void) {
+    if (!s_ring) return;
+
+    AL_AtomicStore(&s_ring->claimed, false, AL_RELEASE);
+    s_ring = NULL;
+}
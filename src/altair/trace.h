@@ -0,0 +1,55 @@
+#ifndef AL_TRACE_H_
+#define AL_TRACE_H_
+
+#include "aldefs.h"
+
+#define AL_TRACE_MAX_THREADS 128
+
+// per thread; a thread that outruns flushing loses its oldest spans
+#define AL_TRACE_RING_EVENTS (1 << 14)
+
+// one completed span; 'name' must outlive the trace, 'id' names what it was about
+typedef struct AL_TraceEvent_ {
+    const char* name;
+    u64         id;
+    u64         begin_ns;
+    u64         end_ns;
+} AL_TraceEvent;
+
+// single producer ring, owned by one thread at a time and drained by the flushing thread
+typedef struct AL_TraceRing_ {
+    AL_TraceEvent* events;
+    u64            head;    // atomic, events ever written
+    u64            tail;    // flusher only, events ever drained
+    u64            claimed; // atomic
+    u8             padding[AL_CACHE_LINE - 3 * sizeof(u64) - sizeof(AL_TraceEvent*)];
+} AL_TraceRing;
+
+// starts recording spans into per-thread rings, flushed as Chrome trace events (the JSON
+// format chrome://tracing and Perfetto open) into 'filepath'
+ALAPI b8   AL_StartTrace(const char* filepath);
+
+// drains every thread's ring into the trace file; one flushing thread at a time
+ALAPI b8   AL_FlushTrace(void);
+
+// stops recording, flushes and closes the file
+ALAPI b8   AL_StopTrace(void);
+
+ALAPI b8   AL_IsTracing(void);
+
+// 0 while tracing is off, in which case the matching end does nothing
+ALAPI u64  AL_TraceBegin(void);
+
+// records the span [begin, now) on the calling thread's ring, claiming one on first use
+ALAPI void AL_TraceEnd(const char* name, u64 id, u64 begin);
+
+// the same, for a caller that already read the clock at both ends
+ALAPI void AL_TraceSpan(const char* name, u64 id, u64 begin, u64 end);
+
+// names 'id' in the trace's args; registered only while tracing, the first label wins
+ALAPI void AL_TraceLabel(u64 id, const char* label);
+
+// gives the calling thread's ring back, e.g. before it exits; its events are still flushed
+ALAPI void AL_ReleaseTraceRing(void);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef AL_TESTS_CHECK_H_
+#define AL_TESTS_CHECK_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// a failed check ends the test right away, naming where it failed
+#define CHECK(condition)                                                                           \
+    do {                                                                                           \
+        if (!(condition)) {                                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);          \
+            exit(1);                                                                               \
+        }                                                                                          \
+    } while (0)
+
+#endif
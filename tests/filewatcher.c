@@ -0,0 +1,139 @@
+#include "altair/atomic.h"
+#include "altair/clock.h"
+#include "altair/filewatcher.h"
+#include "altair/reactor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check.h"
+
+// the merged event a plugin file comes out as, however it was written: in place, or built
+// elsewhere and renamed over it as build tools install their outputs
+
+#define QUIET_MS 20
+
+typedef struct {
+    u32 added;    // atomic
+    u32 modified; // atomic
+    u32 removed;  // atomic
+} Counts;
+
+static Counts s_counts;
+static char   s_directory[] = "/tmp/altair-filewatcher-XXXXXX";
+
+static void   s_OnAdded(AL_String directory, AL_String file, void* argument) {
+    (void)directory;
+    (void)file;
+    AL_AtomicAdd(&((Counts*)argument)->added, 1, AL_RELAXED);
+}
+
+static void s_OnModified(AL_String directory, AL_String file, void* argument) {
+    (void)directory;
+    (void)file;
+    AL_AtomicAdd(&((Counts*)argument)->modified, 1, AL_RELAXED);
+}
+
+static void s_OnRemoved(AL_String directory, AL_String file, void* argument) {
+    (void)directory;
+    (void)file;
+    AL_AtomicAdd(&((Counts*)argument)->removed, 1, AL_RELAXED);
+}
+
+static void s_Write(const char* name, const char* contents) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", s_directory, name);
+
+    FILE* file = fopen(path, "w");
+    CHECK(file != NULL);
+    fputs(contents, file);
+    fclose(file);
+}
+
+static void s_Rename(const char* from, const char* to) {
+    char source[256], destination[256];
+    snprintf(source, sizeof(source), "%s/%s", s_directory, from);
+    snprintf(destination, sizeof(destination), "%s/%s", s_directory, to);
+    CHECK(rename(source, destination) == 0);
+}
+
+// waits for an event to come out, then for a few more windows so nothing else follows it
+static Counts s_Settle(void) {
+    u64 deadline = AL_GetTime() + 2000 * AL_NS_PER_MS;
+    while (AL_GetTime() < deadline) {
+        if (AL_AtomicLoad(&s_counts.added, AL_RELAXED) ||
+            AL_AtomicLoad(&s_counts.modified, AL_RELAXED) ||
+            AL_AtomicLoad(&s_counts.removed, AL_RELAXED))
+            break;
+        AL_SleepUntil(AL_GetTime() + AL_NS_PER_MS);
+    }
+
+    AL_SleepUntil(AL_GetTime() + 5 * QUIET_MS * AL_NS_PER_MS);
+
+    Counts counts = { .added    = AL_AtomicExchange(&s_counts.added, 0, AL_RELAXED),
+                      .modified = AL_AtomicExchange(&s_counts.modified, 0, AL_RELAXED),
+                      .removed  = AL_AtomicExchange(&s_counts.removed, 0, AL_RELAXED) };
+    return counts;
+}
+
+int main(void) {
+    CHECK(mkdtemp(s_directory) != NULL);
+    s_Write("plugin.so", "v1");
+
+    char watched[256];
+    snprintf(watched, sizeof(watched), "%s/", s_directory);
+
+    AL_Reactor reactor;
+    CHECK(AL_CreateReactor(&reactor));
+
+    AL_FileWatcher watcher;
+    CHECK(AL_CreateFileWatcher(watched, 1, "*.so*", &reactor, &watcher));
+    AL_SetQuietWindow(&watcher, QUIET_MS);
+
+    AL_AddFileCallback(&watcher, s_OnAdded, FILE_ADDED, &s_counts);
+    AL_AddFileCallback(&watcher, s_OnModified, FILE_MODIFIED, &s_counts);
+    AL_AddFileCallback(&watcher, s_OnRemoved, FILE_REMOVED, &s_counts);
+
+    // the startup pass touches the plugin already there
+    Counts counts = s_Settle();
+    CHECK(counts.modified == 1 && counts.added == 0);
+
+    // rewritten in place
+    s_Write("plugin.so", "v2, longer");
+    counts = s_Settle();
+    CHECK(counts.modified == 1 && counts.added == 0 && counts.removed == 0);
+
+    // built next to it under a name the filter skips, then renamed over it
+    s_Write("plugin.tmp", "v3");
+    s_Rename("plugin.tmp", "plugin.so");
+    counts = s_Settle();
+    CHECK(counts.modified == 1 && counts.added == 0 && counts.removed == 0);
+
+    // renamed into place under a name never seen before
+    s_Write("other.tmp", "v1");
+    s_Rename("other.tmp", "other.so");
+    counts = s_Settle();
+    CHECK(counts.added == 1 && counts.modified == 0);
+
+    // removed, then installed again
+    char path[256];
+    snprintf(path, sizeof(path), "%s/other.so", s_directory);
+    CHECK(unlink(path) == 0);
+    counts = s_Settle();
+    CHECK(counts.removed == 1);
+
+    s_Write("other.tmp", "v2");
+    s_Rename("other.tmp", "other.so");
+    counts = s_Settle();
+    CHECK(counts.added == 1 && counts.modified == 0);
+
+    CHECK(AL_DestroyFileWatcher(&watcher));
+    CHECK(AL_DestroyReactor(&reactor));
+
+    char command[300];
+    snprintf(command, sizeof(command), "rm -rf %s", s_directory);
+    CHECK(system(command) == 0);
+    return 0;
+}
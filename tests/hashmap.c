@@ -0,0 +1,247 @@
+#include "altair/hashmap.h"
+
+#include <string.h>
+
+#include "check.h"
+
+// mirrors the map's own mixing, so keys can be picked by the slot they hash to
+static u64 s_Home(const AL_HashMap* map, u64 key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccd;
+    key ^= key >> 33;
+    return key & (map->capacity - 1);
+}
+
+// the next key after 'after' whose home slot is 'home'
+static u64 s_KeyAt(const AL_HashMap* map, u64 home, u64 after) {
+    for (u64 key = after + 1;; ++key) {
+        if (s_Home(map, key) == home) return key;
+    }
+}
+
+static u64 s_SlotOf(const AL_HashMap* map, u64 key) {
+    for (u64 i = 0; i < map->capacity; ++i) {
+        if (map->entries[i].key == key) return i;
+    }
+
+    return map->capacity;
+}
+
+// linear probing without tombstones: every entry is reachable from its home slot without
+// crossing an empty one, and the count matches the occupied slots
+static void s_CheckInvariants(const AL_HashMap* map) {
+    u64 mask     = map->capacity - 1;
+    u64 occupied = 0;
+
+    for (u64 i = 0; i < map->capacity; ++i) {
+        u64 key = map->entries[i].key;
+        if (key == AL_HASHMAP_EMPTY_KEY) continue;
+
+        occupied += 1;
+        for (u64 slot = s_Home(map, key); slot != i; slot = (slot + 1) & mask)
+            CHECK(map->entries[slot].key != AL_HASHMAP_EMPTY_KEY);
+    }
+
+    CHECK(occupied == map->count);
+    CHECK(map->count * 2 <= map->capacity);
+}
+
+static void s_TestBasics(void) {
+    AL_HashMap map;
+    u64        value = 0;
+
+    CHECK(AL_CreateHashMap(0, &map));
+    CHECK(!AL_HashMapFind(&map, 42, &value));
+    CHECK(!AL_HashMapErase(&map, 42));
+
+    CHECK(AL_HashMapInsert(&map, 42, 1));
+    CHECK(AL_HashMapFind(&map, 42, &value) && value == 1);
+    CHECK(AL_HashMapFind(&map, 42, NULL));
+
+    // overwriting keeps one entry
+    CHECK(AL_HashMapInsert(&map, 42, 2));
+    CHECK(AL_HashMapFind(&map, 42, &value) && value == 2);
+    CHECK(map.count == 1);
+
+    // the empty key is reserved
+    CHECK(!AL_HashMapInsert(&map, AL_HASHMAP_EMPTY_KEY, 3));
+    CHECK(!AL_HashMapFind(&map, AL_HASHMAP_EMPTY_KEY, NULL));
+
+    CHECK(AL_HashMapErase(&map, 42));
+    CHECK(!AL_HashMapFind(&map, 42, NULL));
+    CHECK(!AL_HashMapErase(&map, 42));
+    CHECK(map.count == 0);
+
+    AL_DestroyHashMap(&map);
+    CHECK(map.entries == NULL && map.capacity == 0);
+}
+
+// a chain that starts in the last slot carries on at the first
+static void s_TestWraparound(void) {
+    AL_HashMap map;
+    CHECK(AL_CreateHashMap(0, &map));
+
+    u64 last = map.capacity - 1;
+    u64 a    = s_KeyAt(&map, last, 0);
+    u64 b    = s_KeyAt(&map, last, a);
+    u64 c    = s_KeyAt(&map, last, b);
+    u64 d    = s_KeyAt(&map, 0, 0); // homes where the chain has wrapped to
+
+    CHECK(AL_HashMapInsert(&map, a, 1));
+    CHECK(AL_HashMapInsert(&map, b, 2));
+    CHECK(AL_HashMapInsert(&map, c, 3));
+    CHECK(AL_HashMapInsert(&map, d, 4));
+
+    CHECK(s_SlotOf(&map, a) == last);
+    CHECK(s_SlotOf(&map, b) == 0);
+    CHECK(s_SlotOf(&map, c) == 1);
+    CHECK(s_SlotOf(&map, d) == 2);
+    s_CheckInvariants(&map);
+
+    // everything behind the hole shifts back across the end of the table
+    CHECK(AL_HashMapErase(&map, a));
+    CHECK(s_SlotOf(&map, b) == last);
+    CHECK(s_SlotOf(&map, c) == 0);
+    CHECK(s_SlotOf(&map, d) == 1);
+    s_CheckInvariants(&map);
+
+    u64 value = 0;
+    CHECK(AL_HashMapFind(&map, b, &value) && value == 2);
+    CHECK(AL_HashMapFind(&map, c, &value) && value == 3);
+    CHECK(AL_HashMapFind(&map, d, &value) && value == 4);
+
+    AL_DestroyHashMap(&map);
+}
+
+// an entry already at its home slot must not move into a hole before it
+static void s_TestBackwardShift(void) {
+    AL_HashMap map;
+    CHECK(AL_CreateHashMap(0, &map));
+
+    u64 a = s_KeyAt(&map, 4, 0);
+    u64 b = s_KeyAt(&map, 4, a);
+    u64 c = s_KeyAt(&map, 6, 0);
+    u64 d = s_KeyAt(&map, 4, b);
+
+    CHECK(AL_HashMapInsert(&map, a, 1));
+    CHECK(AL_HashMapInsert(&map, b, 2));
+    CHECK(AL_HashMapInsert(&map, c, 3));
+    CHECK(AL_HashMapInsert(&map, d, 4)); // past c, in slot 7
+
+    CHECK(s_SlotOf(&map, d) == 7);
+
+    // b's hole is filled by d, jumping over c, which stays home
+    CHECK(AL_HashMapErase(&map, b));
+    CHECK(s_SlotOf(&map, a) == 4);
+    CHECK(s_SlotOf(&map, d) == 5);
+    CHECK(s_SlotOf(&map, c) == 6);
+    CHECK(map.entries[7].key == AL_HASHMAP_EMPTY_KEY);
+    s_CheckInvariants(&map);
+
+    CHECK(AL_HashMapErase(&map, a));
+    CHECK(s_SlotOf(&map, d) == 4);
+    CHECK(s_SlotOf(&map, c) == 6);
+    s_CheckInvariants(&map);
+
+    AL_DestroyHashMap(&map);
+}
+
+static void s_TestResize(void) {
+    AL_HashMap map;
+    CHECK(AL_CreateHashMap(0, &map));
+
+    u64 initial = map.capacity;
+    u64 count   = initial * 64;
+
+    for (u64 key = 1; key <= count; ++key) {
+        CHECK(AL_HashMapInsert(&map, key * 0x9E3779B97F4A7C15, key));
+        if ((key & (key - 1)) == 0) s_CheckInvariants(&map);
+    }
+
+    CHECK(map.count == count);
+    CHECK(map.capacity > initial);
+    s_CheckInvariants(&map);
+
+    for (u64 key = 1; key <= count; ++key) {
+        u64 value = 0;
+        CHECK(AL_HashMapFind(&map, key * 0x9E3779B97F4A7C15, &value) && value == key);
+    }
+
+    // a map sized up front never grows
+    AL_HashMap sized;
+    CHECK(AL_CreateHashMap(count, &sized));
+
+    u64 capacity = sized.capacity;
+    for (u64 key = 1; key <= count; ++key) CHECK(AL_HashMapInsert(&sized, key, key));
+    CHECK(sized.capacity == capacity);
+
+    AL_DestroyHashMap(&sized);
+    AL_DestroyHashMap(&map);
+}
+
+static void s_TestClone(void) {
+    AL_HashMap map, clone;
+    CHECK(AL_CreateHashMap(0, &map));
+
+    for (u64 key = 1; key <= 100; ++key) CHECK(AL_HashMapInsert(&map, key, key * 2));
+    CHECK(AL_CloneHashMap(&map, &clone));
+
+    // independent once cloned
+    CHECK(AL_HashMapErase(&map, 50));
+    CHECK(AL_HashMapFind(&clone, 50, NULL));
+    CHECK(clone.count == 100 && map.count == 99);
+    s_CheckInvariants(&clone);
+
+    AL_DestroyHashMap(&clone);
+    AL_DestroyHashMap(&map);
+}
+
+// random inserts and erases over a small key space, so chains collide, wrap and resize,
+// checked against a plain table after every operation
+static void s_TestRandomized(void) {
+    enum { KEYS = 512, STEPS = 200000 };
+
+    AL_HashMap map;
+    u64        expected[KEYS + 1];
+    u64        state = 0x2545F4914F6CDD1D;
+
+    memset(expected, 0, sizeof(expected));
+    CHECK(AL_CreateHashMap(0, &map));
+
+    for (u64 step = 0; step < STEPS; ++step) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        u64 key = state % KEYS + 1;
+
+        if (state >> 62) {
+            CHECK(AL_HashMapInsert(&map, key, step + 1));
+            expected[key] = step + 1;
+        } else {
+            CHECK(AL_HashMapErase(&map, key) == (expected[key] != 0));
+            expected[key] = 0;
+        }
+
+        if (step % 1024 == 0) s_CheckInvariants(&map);
+    }
+
+    s_CheckInvariants(&map);
+    for (u64 key = 1; key <= KEYS; ++key) {
+        u64 value = 0;
+        CHECK(AL_HashMapFind(&map, key, &value) == (expected[key] != 0));
+        CHECK(!expected[key] || value == expected[key]);
+    }
+
+    AL_DestroyHashMap(&map);
+}
+
+int main(void) {
+    s_TestBasics();
+    s_TestWraparound();
+    s_TestBackwardShift();
+    s_TestResize();
+    s_TestClone();
+    s_TestRandomized();
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "altair/atomic.h"
+#include "altair/clock.h"
+#include "altair/threads.h"
+
+#include <stdlib.h>
+
+#include "check.h"
+
+// the handshake of AL_DestroyThread: SYNC_EXIT is swapped in unless the routine is done, and
+// the thread and its context may only be freed once the wrapper has stored SYNC_WAIT
+
+typedef struct {
+    AL_Thread thread;
+    u32       ran;     // atomic
+    u32       exited;  // atomic, the routine saw SYNC_EXIT
+    u64       hold_ns; // ignores the flag this long before polling it
+    b8        poll;    // polls until told to exit, or returns right away
+} Worker;
+
+static u32 s_WorkerProc(void* user_context) {
+    Worker* worker = user_context;
+    AL_AtomicStore(&worker->ran, 1, AL_RELEASE);
+
+    if (worker->hold_ns) AL_SleepUntil(AL_GetTime() + worker->hold_ns);
+    if (!worker->poll) return true;
+
+    while (AL_ReadSyncFlag(&worker->thread.mutex) != SYNC_EXIT)
+        AL_AwaitSyncFlag(&worker->thread.mutex, AL_TIMEOUT_MAX);
+
+    AL_AtomicStore(&worker->exited, 1, AL_RELEASE);
+    return true;
+}
+
+static Worker* s_Spawn(b8 poll, u64 hold_ns, b8 launch) {
+    Worker* worker  = calloc(1, sizeof(Worker));
+    worker->poll    = poll;
+    worker->hold_ns = hold_ns;
+
+    CHECK(AL_CreateThread(s_WorkerProc, worker, launch, &worker->thread));
+    return worker;
+}
+
+static void s_TestSyncFlag(void) {
+    AL_Mutex mutex = AL_CreateMutex();
+
+    CHECK(AL_ReadSyncFlag(&mutex) == SYNC_UNSET);
+    CHECK(!AL_AwaitSyncFlag(&mutex, 1));
+
+    // a read claims the flag
+    AL_WriteSyncFlag(&mutex, SYNC_WAIT);
+    CHECK(AL_AwaitSyncFlag(&mutex, 1));
+    CHECK(AL_ReadSyncFlag(&mutex) == SYNC_WAIT);
+    CHECK(AL_ReadSyncFlag(&mutex) == SYNC_UNSET);
+    CHECK(mutex.heartbeat != 0);
+
+    // a ping reads and awaits as unset, and is only sent again once answered
+    mutex.heartbeat = 0;
+    CHECK(AL_ReadSyncFlag(&mutex) == SYNC_UNSET && mutex.heartbeat == 0);
+    CHECK(AL_PingSyncFlag(&mutex));
+    CHECK(!AL_PingSyncFlag(&mutex));
+    CHECK(!AL_AwaitSyncFlag(&mutex, 1));
+    CHECK(AL_ReadSyncFlag(&mutex) == SYNC_UNSET && mutex.heartbeat != 0);
+    CHECK(AL_PingSyncFlag(&mutex));
+
+    // nor does it hide a flag written over it
+    AL_WriteSyncFlag(&mutex, SYNC_EXIT);
+    CHECK(!AL_PingSyncFlag(&mutex));
+    CHECK(AL_AwaitSyncFlag(&mutex, 1));
+    CHECK(AL_ReadSyncFlag(&mutex) == SYNC_EXIT);
+
+    AL_DestroyMutex(&mutex);
+}
+
+// the routine is polling when SYNC_EXIT comes in
+static void s_TestExitWhilePolling(void) {
+    Worker* worker = s_Spawn(true, 0, true);
+    while (!AL_AtomicLoad(&worker->ran, AL_ACQUIRE)) AL_Yield();
+
+    CHECK(AL_DestroyThread(&worker->thread, AL_TIMEOUT_MAX));
+    CHECK(AL_AtomicLoad(&worker->exited, AL_ACQUIRE));
+    free(worker);
+}
+
+// the routine returned on its own, so the flag is already SYNC_WAIT and nothing is swapped in
+static void s_TestAlreadyReturned(void) {
+    Worker* worker = s_Spawn(false, 0, true);
+    while (AL_AtomicLoad(&worker->thread.mutex.flag, AL_ACQUIRE) != SYNC_WAIT) AL_Yield();
+
+    CHECK(AL_DestroyThread(&worker->thread, 0));
+    CHECK(AL_AtomicLoad(&worker->ran, AL_ACQUIRE));
+    free(worker);
+}
+
+// never started: SYNC_EXIT reaches the wrapper instead of SYNC_START
+static void s_TestNeverStarted(void) {
+    Worker* worker = s_Spawn(true, 0, false);
+
+    CHECK(AL_DestroyThread(&worker->thread, AL_TIMEOUT_MAX));
+    CHECK(!AL_AtomicLoad(&worker->ran, AL_ACQUIRE));
+    free(worker);
+}
+
+// a routine slower than the timeout is left running with SYNC_EXIT pending, and a second
+// destroy waits it out
+static void s_TestTimeout(void) {
+    Worker* worker = s_Spawn(true, 100 * AL_NS_PER_MS, true);
+    while (!AL_AtomicLoad(&worker->ran, AL_ACQUIRE)) AL_Yield();
+
+    CHECK(!AL_DestroyThread(&worker->thread, 10));
+    CHECK(!AL_AtomicLoad(&worker->exited, AL_ACQUIRE));
+
+    CHECK(AL_DestroyThread(&worker->thread, AL_TIMEOUT_MAX));
+    CHECK(AL_AtomicLoad(&worker->exited, AL_ACQUIRE));
+    free(worker);
+}
+
+// destroys race the routine at every point of its life; freeing right after is only safe if
+// the wrapper touches nothing past its final store
+static void s_TestRaces(void) {
+    enum { ROUNDS = 500 };
+
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        Worker* worker = s_Spawn(round % 2 == 0, 0, round % 3 != 0);
+        if (round % 5 == 0) AL_Yield();
+        if (round % 3 == 0 && round % 4 == 0) AL_StartThread(&worker->thread);
+
+        CHECK(AL_DestroyThread(&worker->thread, AL_TIMEOUT_MAX));
+        CHECK(!worker->poll || !AL_AtomicLoad(&worker->ran, AL_ACQUIRE) ||
+              AL_AtomicLoad(&worker->exited, AL_ACQUIRE));
+        free(worker);
+    }
+}
+
+int main(void) {
+    s_TestSyncFlag();
+    s_TestExitWhilePolling();
+    s_TestAlreadyReturned();
+    s_TestNeverStarted();
+    s_TestTimeout();
+    s_TestRaces();
+    return 0;
+}